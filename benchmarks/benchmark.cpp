@@ -1,5 +1,11 @@
 #include "zerolog/logger.hpp"
+#include "zerolog/formatters.hpp"
+#include "zerolog/intern.hpp"
+#include "zerolog/single_thread_logger.hpp"
+#include "zerolog/sinks/file_sink.hpp"
 #include <benchmark/benchmark.h>
+#include <fmt/chrono.h>
+#include <arpa/inet.h>
 #include <atomic>
 #include <thread>
 
@@ -15,6 +21,42 @@ static void BM_ZeroLog_Sync(benchmark::State& state) {
 }
 BENCHMARK(BM_ZeroLog_Sync);
 
+// Synchronous into a buffered file sink, whose buffer both loggers format
+// straight into
+static void BM_ZeroLog_Sync_File(benchmark::State& state) {
+    Logger<FileSink> logger(FileSink("/dev/null"), false);
+    
+    for (auto _ : state) {
+        logger.info("Test message {}", state.iterations());
+    }
+}
+BENCHMARK(BM_ZeroLog_Sync_File);
+
+static void BM_SingleThreadLogger_File(benchmark::State& state) {
+    SingleThreadLogger<FileSink> logger(FileSink("/dev/null"));
+    
+    for (auto _ : state) {
+        logger.info("Test message {}", state.iterations());
+    }
+}
+BENCHMARK(BM_SingleThreadLogger_File);
+
+// Producer and consumer on one thread (MANUAL mode), so dequeuing into the
+// file sink's buffer is on the clock too
+static void BM_ZeroLog_Manual_File(benchmark::State& state) {
+    LoggerOptions opts;
+    opts.mode = LogMode::MANUAL;
+    Logger<FileSink> logger(FileSink("/dev/null"), opts);
+    
+    for (auto _ : state) {
+        logger.info("Test message {}", state.iterations());
+        if (state.iterations() % 64 == 0) {
+            logger.drain();
+        }
+    }
+}
+BENCHMARK(BM_ZeroLog_Manual_File);
+
 // Single-threaded asynchronous
 static void BM_ZeroLog_Async_ST(benchmark::State& state) {
     Logger<NullSink> logger(NullSink{}, true);
@@ -27,6 +69,107 @@ static void BM_ZeroLog_Async_ST(benchmark::State& state) {
 }
 BENCHMARK(BM_ZeroLog_Async_ST);
 
+// Same, with the ring in a MAP_SHARED file that survives the process
+static void BM_ZeroLog_Async_Persistent(benchmark::State& state) {
+    LoggerOptions opts;
+    opts.mode = LogMode::ASYNC;
+    opts.persistent_path = "/tmp/zerolog_bench.ring";
+    {
+        Logger<NullSink> logger(NullSink{}, opts);
+        
+        for (auto _ : state) {
+            logger.info("Test message {}", state.iterations());
+        }
+        
+        logger.flush();
+    }
+    unlink(opts.persistent_path.c_str());
+}
+BENCHMARK(BM_ZeroLog_Async_Persistent);
+
+// Same, with arguments encoded on the producer and formatted by the worker
+static void BM_ZeroLog_Async_Deferred(benchmark::State& state) {
+    LoggerOptions opts;
+    opts.mode = LogMode::ASYNC;
+    opts.deferred = true;
+    Logger<NullSink> logger(NullSink{}, opts);
+    
+    for (auto _ : state) {
+        logger.info("Test message {} {}", state.iterations(), 3.14159);
+    }
+    
+    logger.flush();
+}
+BENCHMARK(BM_ZeroLog_Async_Deferred);
+
+// A freshly built 200-byte string per call: formatted eagerly (0) or moved
+// into the record by deferred mode (1)
+static void BM_ZeroLog_Async_StringTemporary(benchmark::State& state) {
+    LoggerOptions opts;
+    opts.mode = LogMode::ASYNC;
+    opts.deferred = state.range(0) != 0;
+    Logger<NullSink> logger(NullSink{}, opts);
+    
+    for (auto _ : state) {
+        logger.info("Request body: {}", std::string(200, 'x'));
+    }
+    
+    logger.flush();
+}
+BENCHMARK(BM_ZeroLog_Async_StringTemporary)->Arg(0)->Arg(1);
+
+// Deferred mode with an endpoint name from a small set: copied into every
+// record (0) or interned (1)
+static void BM_ZeroLog_Async_Interned(benchmark::State& state) {
+    LoggerOptions opts;
+    opts.mode = LogMode::ASYNC;
+    opts.deferred = true;
+    Logger<NullSink> logger(NullSink{}, opts);
+    const std::string endpoints[] = {"/api/v2/orders/submit", "/api/v2/orders/cancel",
+                                     "/api/v2/accounts/balance", "/api/v2/market/depth"};
+    
+    size_t i = 0;
+    for (auto _ : state) {
+        const std::string& endpoint = endpoints[i++ % 4];
+        if (state.range(0)) {
+            logger.info("{} served", intern(endpoint));
+        } else {
+            logger.info("{} served", endpoint);
+        }
+    }
+    
+    logger.flush();
+}
+BENCHMARK(BM_ZeroLog_Async_Interned)->Arg(0)->Arg(1);
+
+// Single-threaded asynchronous, one run per wait strategy
+template<typename Wait>
+static void BM_ZeroLog_Async_Wait(benchmark::State& state) {
+    Logger<NullSink, LogLevel::TRACE, Wait> logger(NullSink{}, true);
+    
+    for (auto _ : state) {
+        logger.info("Test message {}", state.iterations());
+    }
+    
+    logger.flush();
+}
+BENCHMARK_TEMPLATE(BM_ZeroLog_Async_Wait, BlockingWait);
+BENCHMARK_TEMPLATE(BM_ZeroLog_Async_Wait, SpinParkWait);
+BENCHMARK_TEMPLATE(BM_ZeroLog_Async_Wait, YieldingWait);
+BENCHMARK_TEMPLATE(BM_ZeroLog_Async_Wait, BusySpinWait);
+
+// Single-threaded asynchronous with the single-producer ring (no CAS on tail)
+static void BM_ZeroLog_Async_SingleProducer(benchmark::State& state) {
+    Logger<NullSink, LogLevel::TRACE, BlockingWait, SingleProducer> logger(NullSink{}, true);
+    
+    for (auto _ : state) {
+        logger.info("Test message {}", state.iterations());
+    }
+    
+    logger.flush();
+}
+BENCHMARK(BM_ZeroLog_Async_SingleProducer);
+
 // Multi-threaded: measures per-thread latency under contention
 static void BM_ZeroLog_Async_MT(benchmark::State& state) {
     Logger<NullSink> logger(NullSink{}, true);
@@ -58,4 +201,110 @@ static void BM_ZeroLog_Async_MT(benchmark::State& state) {
 }
 BENCHMARK(BM_ZeroLog_Async_MT)->UseRealTime();
 
+// A hot loop with 16 log statements on branches that never fire (1), against
+// the same branches without them (0): what idle log statements cost the code
+// around them
+template<bool WithLogs>
+[[gnu::noinline]] static uint64_t hot_loop(Logger<NullSink>& logger, const std::vector<uint32_t>& data) {
+    uint64_t sum = 0;
+    uint64_t rare = 0;
+    for (size_t i = 0; i < data.size(); ++i) {
+        uint32_t v = data[i];
+        sum += v * 2654435761u;
+#define ZEROLOG_IDLE_LOG(n) \
+        if (v == 0xFFFFFF00u + n) { \
+            if constexpr (WithLogs) logger.warn("sentinel " #n " {} at {}", v, i); \
+            else ++rare; \
+        }
+        ZEROLOG_IDLE_LOG(0) ZEROLOG_IDLE_LOG(1) ZEROLOG_IDLE_LOG(2) ZEROLOG_IDLE_LOG(3)
+        ZEROLOG_IDLE_LOG(4) ZEROLOG_IDLE_LOG(5) ZEROLOG_IDLE_LOG(6) ZEROLOG_IDLE_LOG(7)
+        ZEROLOG_IDLE_LOG(8) ZEROLOG_IDLE_LOG(9) ZEROLOG_IDLE_LOG(10) ZEROLOG_IDLE_LOG(11)
+        ZEROLOG_IDLE_LOG(12) ZEROLOG_IDLE_LOG(13) ZEROLOG_IDLE_LOG(14) ZEROLOG_IDLE_LOG(15)
+#undef ZEROLOG_IDLE_LOG
+    }
+    return sum + rare;
+}
+
+static void BM_HotLoop_IdleLogStatements(benchmark::State& state) {
+    Logger<NullSink> logger(NullSink{}, false);
+    std::vector<uint32_t> data(4096);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint32_t>(i * 7919);
+    }
+    
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(state.range(0) ? hot_loop<true>(logger, data) : hot_loop<false>(logger, data));
+    }
+    state.SetItemsProcessed(state.iterations() * data.size());
+}
+BENCHMARK(BM_HotLoop_IdleLogStatements)->Arg(0)->Arg(1);
+
+// formatters.hpp wrappers against what fmt offers for the same values:
+// <fmt/chrono.h>, inet_ntop and per-byte hex
+static void BM_Format(benchmark::State& state, void (*format)(fmt::memory_buffer&)) {
+    fmt::memory_buffer buf;
+    for (auto _ : state) {
+        buf.clear();
+        format(buf);
+        benchmark::DoNotOptimize(buf.data());
+    }
+}
+
+static const uint8_t bench_uuid[16] = {0x12, 0x3e, 0x45, 0x67, 0xe8, 0x9b, 0x12, 0xd3,
+                                       0xa4, 0x56, 0x42, 0x66, 0x14, 0x17, 0x40, 0x00};
+static const std::chrono::nanoseconds bench_duration{1'534'000};
+static const std::chrono::system_clock::time_point bench_time{std::chrono::nanoseconds(1'714'564'800'123'456'789)};
+
+static in_addr bench_ipv4() {
+    in_addr addr;
+    inet_pton(AF_INET, "192.168.100.254", &addr);
+    return addr;
+}
+
+static in6_addr bench_ipv6() {
+    in6_addr addr;
+    inet_pton(AF_INET6, "2001:db8:85a3::8a2e:370:7334", &addr);
+    return addr;
+}
+
+BENCHMARK_CAPTURE(BM_Format, Duration_fmt, [](fmt::memory_buffer& buf) {
+    fmt::format_to(std::back_inserter(buf), "{}", bench_duration);
+});
+BENCHMARK_CAPTURE(BM_Format, Duration_zerolog, [](fmt::memory_buffer& buf) {
+    fmt::format_to(std::back_inserter(buf), "{}", Duration(bench_duration));
+});
+BENCHMARK_CAPTURE(BM_Format, TimePoint_fmt, [](fmt::memory_buffer& buf) {
+    fmt::format_to(std::back_inserter(buf), "{:%Y-%m-%dT%H:%M:%S}Z", bench_time);
+});
+BENCHMARK_CAPTURE(BM_Format, TimePoint_zerolog, [](fmt::memory_buffer& buf) {
+    fmt::format_to(std::back_inserter(buf), "{}", TimePoint(bench_time));
+});
+BENCHMARK_CAPTURE(BM_Format, Ipv4_inet_ntop, [](fmt::memory_buffer& buf) {
+    static const in_addr addr = bench_ipv4();
+    char text[INET_ADDRSTRLEN];
+    fmt::format_to(std::back_inserter(buf), "{}", inet_ntop(AF_INET, &addr, text, sizeof(text)));
+});
+BENCHMARK_CAPTURE(BM_Format, Ipv4_zerolog, [](fmt::memory_buffer& buf) {
+    static const in_addr addr = bench_ipv4();
+    fmt::format_to(std::back_inserter(buf), "{}", Ipv4(addr));
+});
+BENCHMARK_CAPTURE(BM_Format, Ipv6_inet_ntop, [](fmt::memory_buffer& buf) {
+    static const in6_addr addr = bench_ipv6();
+    char text[INET6_ADDRSTRLEN];
+    fmt::format_to(std::back_inserter(buf), "{}", inet_ntop(AF_INET6, &addr, text, sizeof(text)));
+});
+BENCHMARK_CAPTURE(BM_Format, Ipv6_zerolog, [](fmt::memory_buffer& buf) {
+    static const in6_addr addr = bench_ipv6();
+    fmt::format_to(std::back_inserter(buf), "{}", Ipv6(addr));
+});
+BENCHMARK_CAPTURE(BM_Format, Uuid_fmt, [](fmt::memory_buffer& buf) {
+    const uint8_t* u = bench_uuid;
+    fmt::format_to(std::back_inserter(buf),
+                   "{:02x}{:02x}{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}-{:02x}{:02x}{:02x}{:02x}{:02x}{:02x}",
+                   u[0], u[1], u[2], u[3], u[4], u[5], u[6], u[7], u[8], u[9], u[10], u[11], u[12], u[13], u[14], u[15]);
+});
+BENCHMARK_CAPTURE(BM_Format, Uuid_zerolog, [](fmt::memory_buffer& buf) {
+    fmt::format_to(std::back_inserter(buf), "{}", Uuid(bench_uuid));
+});
+
 BENCHMARK_MAIN();
@@ -0,0 +1,15 @@
+#include "zerolog/logger.hpp"
+
+// 64 distinct log statements in one function, built as an object for the
+// zerolog_callsite_size target: the size of zerolog_callsites divided by 64
+// is roughly what one statement adds to the function it sits in.
+#define ZEROLOG_CALLSITE(n) \
+    if (i == n) logger.info("callsite " #n ": {} {}", i, n * 0.5);
+#define ZEROLOG_CALLSITES_8(n) \
+    ZEROLOG_CALLSITE(n) ZEROLOG_CALLSITE(n + 1) ZEROLOG_CALLSITE(n + 2) ZEROLOG_CALLSITE(n + 3) \
+    ZEROLOG_CALLSITE(n + 4) ZEROLOG_CALLSITE(n + 5) ZEROLOG_CALLSITE(n + 6) ZEROLOG_CALLSITE(n + 7)
+
+void zerolog_callsites(zerolog::Logger<zerolog::NullSink>& logger, int i) {
+    ZEROLOG_CALLSITES_8(0) ZEROLOG_CALLSITES_8(8) ZEROLOG_CALLSITES_8(16) ZEROLOG_CALLSITES_8(24)
+    ZEROLOG_CALLSITES_8(32) ZEROLOG_CALLSITES_8(40) ZEROLOG_CALLSITES_8(48) ZEROLOG_CALLSITES_8(56)
+}
@@ -0,0 +1,30 @@
+// 1,000 log statements spread over 125 functions, compiled by the
+// zerolog_compile_time target once against logger.hpp and once against the
+// log.hpp front end (ZEROLOG_SLIM_FRONTEND).
+#include <string_view>
+#ifdef ZEROLOG_SLIM_FRONTEND
+#include "zerolog/log.hpp"
+using Log = zerolog::LogRef;
+#else
+#include "zerolog/logger.hpp"
+using Log = zerolog::Logger<zerolog::NullSink>&;
+#endif
+
+#define ZEROLOG_CALLSITE_A(n, k) if (i == n * 8 + k) logger.info("request " #n "." #k " took {}us, {} bytes", i, n * 0.5);
+#define ZEROLOG_CALLSITE_B(n, k) if (i == n * 8 + k) logger.warn("peer " #n "." #k " closed: {}", name);
+#define ZEROLOG_CALLSITE_C(n, k) if (i == n * 8 + k) logger.error("order " #n "." #k " rejected on {} after {} fills", name, i);
+#define ZEROLOG_CALLSITE_D(n, k) if (i == n * 8 + k) logger.debug("queue " #n "." #k " depth {}", static_cast<unsigned long>(i));
+#define ZEROLOG_CALLSITES_8(n)                                                                         \
+    void callsites_##n(Log logger, int i, std::string_view name) {                                     \
+        ZEROLOG_CALLSITE_A(n, 0) ZEROLOG_CALLSITE_B(n, 1) ZEROLOG_CALLSITE_C(n, 2) ZEROLOG_CALLSITE_D(n, 3) \
+        ZEROLOG_CALLSITE_A(n, 4) ZEROLOG_CALLSITE_B(n, 5) ZEROLOG_CALLSITE_C(n, 6) ZEROLOG_CALLSITE_D(n, 7) \
+    }
+#define ZEROLOG_CALLSITES_40(n) \
+    ZEROLOG_CALLSITES_8(n##0) ZEROLOG_CALLSITES_8(n##1) ZEROLOG_CALLSITES_8(n##2) \
+    ZEROLOG_CALLSITES_8(n##3) ZEROLOG_CALLSITES_8(n##4)
+#define ZEROLOG_CALLSITES_200(n) \
+    ZEROLOG_CALLSITES_40(n##0) ZEROLOG_CALLSITES_40(n##1) ZEROLOG_CALLSITES_40(n##2) \
+    ZEROLOG_CALLSITES_40(n##3) ZEROLOG_CALLSITES_40(n##4)
+
+ZEROLOG_CALLSITES_200(1) ZEROLOG_CALLSITES_200(2) ZEROLOG_CALLSITES_200(3)
+ZEROLOG_CALLSITES_200(4) ZEROLOG_CALLSITES_200(5)
@@ -0,0 +1,12 @@
+#!/bin/sh
+# Compiler launcher for the zerolog_compile_time target: runs the compile
+# command and prints its wall time next to the target it belongs to.
+start=$(date +%s%N)
+"$@" || exit
+end=$(date +%s%N)
+for arg; do
+    [ "$prev" = "-o" ] && out=$arg
+    prev=$arg
+done
+target=${out%%.dir/*}
+echo "${target##*/}: $(( (end - start) / 1000000 )) ms"
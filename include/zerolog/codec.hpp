@@ -0,0 +1,151 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <fmt/format.h>
+#include "zerolog/log.hpp"
+#include "zerolog/string_pool.hpp"
+
+namespace zerolog {
+
+// Binary encoding of a log argument for deferred formatting. A codec gives
+//
+//   static size_t size(const T&);                 // bytes encode() writes
+//   static char* encode(char* out, const T&);     // returns the end
+//   static U decode(const char*& in);             // advances `in`; U is
+//                                                 // anything fmt can format
+//
+// The producer only encodes; the consumer decodes and formats. Types marked
+// is_trivially_loggable (log.hpp) get a memcpy codec and strings are copied
+// by value (a long std::string passed as an rvalue is moved instead, see
+// MovedStringCodec). Anything else is formatted on the calling thread unless
+// it has its own specialization.
+template<typename T, typename = void>
+struct codec {};
+
+namespace detail {
+
+template<typename T>
+inline constexpr bool is_string_like_v =
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view> ||
+    std::is_same_v<T, const char*> || std::is_same_v<T, char*>;
+
+} // namespace detail
+
+template<typename T>
+struct codec<T, std::enable_if_t<is_trivially_loggable_v<T>>> {
+    static_assert(std::is_trivially_copyable_v<T>, "is_trivially_loggable needs a trivially copyable type");
+    static constexpr size_t size(const T&) { return sizeof(T); }
+    static char* encode(char* out, const T& value) {
+        memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+    static T decode(const char*& in) {
+        T value;
+        memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+};
+
+// [uint16_t length | bytes], decoded as a view into the record.
+template<typename T>
+struct codec<T, std::enable_if_t<detail::is_string_like_v<T>>> {
+    static size_t size(std::string_view sv) { return sizeof(uint16_t) + sv.size(); }
+    static char* encode(char* out, std::string_view sv) {
+        uint16_t len = static_cast<uint16_t>(sv.size());
+        memcpy(out, &len, sizeof(len));
+        memcpy(out + sizeof(len), sv.data(), len);
+        return out + sizeof(len) + len;
+    }
+    static std::string_view decode(const char*& in) {
+        uint16_t len;
+        memcpy(&len, in, sizeof(len));
+        std::string_view sv(in + sizeof(len), len);
+        in += sizeof(len) + len;
+        return sv;
+    }
+};
+
+template<typename T, typename = void>
+struct has_codec : std::false_type {};
+
+template<typename T>
+struct has_codec<T, std::void_t<decltype(codec<T>::encode(std::declval<char*>(), std::declval<const T&>()))>>
+    : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_codec_v = has_codec<T>::value;
+
+namespace detail {
+
+// Codec for a std::string passed as an rvalue: short strings are copied like
+// any other, longer ones are moved into a pooled node and only the node
+// pointer goes into the record. Encoded as [uint8_t moved | pointer or
+// uint16_t length and bytes].
+struct MovedStringCodec {
+    static constexpr size_t MOVE_THRESHOLD = 64;
+
+    static size_t size(const std::string& value) {
+        return 1 + (value.size() >= MOVE_THRESHOLD ? sizeof(StringPool::Node*)
+                                                   : codec<std::string_view>::size(value));
+    }
+    static char* encode(char* out, std::string&& value) {
+        if (value.size() < MOVE_THRESHOLD) {
+            *out = 0;
+            return codec<std::string_view>::encode(out + 1, value);
+        }
+        StringPool::Node* node = StringPool::take(std::move(value));
+        *out = 1;
+        memcpy(out + 1, &node, sizeof(node));
+        return out + 1 + sizeof(node);
+    }
+    static CapturedString decode(const char*& in) {
+        if (*in++ == 0) {
+            return CapturedString(codec<std::string_view>::decode(in));
+        }
+        StringPool::Node* node;
+        memcpy(&node, in, sizeof(node));
+        in += sizeof(node);
+        return CapturedString(node);
+    }
+};
+
+// How one argument of a deferred call is encoded.
+template<typename Arg>
+using arg_codec_t = std::conditional_t<std::is_same_v<Arg, std::string>, MovedStringCodec,
+                                       codec<std::decay_t<Arg>>>;
+
+template<typename T>
+const T& format_view(const T& value) { return value; }
+
+inline std::string_view format_view(const CapturedString& value) { return value.view(); }
+
+// Consumer side of a deferred record: decodes the arguments in order and
+// hands them to `write` as format arguments, valid for the duration of the call.
+using DeferredWrite = void (*)(void* context, fmt::format_args args);
+using DeferredFormat = void (*)(const char* in, DeferredWrite write, void* context);
+
+template<typename... Codecs>
+void format_deferred([[maybe_unused]] const char* in, DeferredWrite write, void* context) {
+    // Braced initialization decodes left to right.
+    std::tuple<decltype(Codecs::decode(in))...> args{Codecs::decode(in)...};
+    std::apply([&](const auto&... values) {
+        write(context, fmt::make_format_args(format_view(values)...));
+    }, args);
+}
+
+// Releases what a dropped record owns; decoding is enough.
+using DeferredDiscard = void (*)(const char*);
+
+template<typename... Codecs>
+void discard_deferred(const char* in) {
+    std::tuple<decltype(Codecs::decode(in))...> args{Codecs::decode(in)...};
+}
+
+} // namespace detail
+
+} // namespace zerolog
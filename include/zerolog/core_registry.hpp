@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+namespace zerolog {
+namespace detail {
+
+// Post-mortem registry: lets zerolog_core_extract find queued records in a
+// core file, with no crash handler. Every ring and every thread's batch
+// links a CoreRegion into the list hanging off zerolog_core_root; the tool
+// finds the root by its magic and follows the pointers through the core's
+// PT_LOAD segments. Fields are fixed-width so the tool needs nothing from
+// the crashed build. Registration happens once per ring and per thread,
+// never on the logging path.
+struct CoreRegion {
+    enum Kind : uint64_t { RING = 1, BATCH = 2 };
+    uint64_t next = 0;        // CoreRegion*
+    uint64_t kind = 0;
+    uint64_t slots = 0;       // char*, slots in BasicRingBuffer's layout
+    uint64_t entry_size = 0;
+    uint64_t capacity = 0;    // slots
+    uint64_t head = 0;        // RING: size_t* to the first record not yet dequeued
+    uint64_t tail = 0;        // RING: size_t* to the next sequence (top bit: sealed)
+                              // BATCH: size_t* to the number of records held
+};
+
+struct CoreRoot {
+    char magic[16];
+    uint64_t version;
+    uint64_t trailer_size;
+    uint64_t regions;  // CoreRegion*
+};
+
+inline constexpr char CORE_MAGIC[16] = "zerolog-core-v1";
+inline constexpr uint64_t CORE_VERSION = 1;
+
+// Both take a lock; a region must stay put while registered.
+void core_register(CoreRegion& region);
+void core_unregister(CoreRegion& region);
+
+} // namespace detail
+} // namespace zerolog
+
+// Defined in libzerolog; `p zerolog_core_root` in gdb shows the same list.
+extern "C" zerolog::detail::CoreRoot zerolog_core_root;
@@ -0,0 +1,273 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fmt/core.h>
+#include <netinet/in.h>
+#include "zerolog/log.hpp"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace zerolog {
+
+// Wrappers for common value types, formatted without allocation, locale or
+// <fmt/chrono.h>. Wrap the value at the call site:
+//
+//   logger.info("{} from {} in {}", Uuid(id), Ipv4(peer.sin_addr), Duration(elapsed));
+//
+// All are trivially copyable and hold no pointers, so deferred mode copies
+// them as a few raw bytes and the text is rendered on the consumer. None
+// takes a format spec.
+
+// "1.5ms": the largest of s, ms, us and ns that fits, up to three decimals.
+struct Duration {
+    int64_t ns;
+    Duration() = default;
+    template<typename Rep, typename Period>
+    explicit Duration(std::chrono::duration<Rep, Period> d)
+        : ns(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()) {}
+};
+
+// "2024-05-01T12:00:00.123456789Z", UTC.
+struct TimePoint {
+    int64_t ns;  // since the Unix epoch
+    TimePoint() = default;
+    explicit TimePoint(std::chrono::system_clock::time_point tp)
+        : ns(std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count()) {}
+};
+
+// "192.168.0.1"
+struct Ipv4 {
+    uint8_t bytes[4];
+    Ipv4() = default;
+    explicit Ipv4(const in_addr& addr) { memcpy(bytes, &addr, sizeof(bytes)); }
+};
+
+// RFC 5952: lowercase, the longest run of zero groups as "::", IPv4-mapped
+// addresses as "::ffff:192.168.0.1".
+struct Ipv6 {
+    uint8_t bytes[16];
+    Ipv6() = default;
+    explicit Ipv6(const in6_addr& addr) { memcpy(bytes, &addr, sizeof(bytes)); }
+};
+
+// "123e4567-e89b-12d3-a456-426614174000"
+struct Uuid {
+    uint8_t bytes[16];
+    Uuid() = default;
+    explicit Uuid(const uint8_t* value) { memcpy(bytes, value, sizeof(bytes)); }
+};
+
+namespace detail {
+
+inline char* write_decimal(char* out, uint64_t value) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+    while (n) *out++ = digits[--n];
+    return out;
+}
+
+inline char* write_padded(char* out, uint64_t value, int width) {
+    for (int i = width; i-- > 0;) {
+        out[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return out + width;
+}
+
+inline char* write_duration(char* out, const Duration& d) {
+    uint64_t ns = d.ns < 0 ? 0 - static_cast<uint64_t>(d.ns) : static_cast<uint64_t>(d.ns);
+    if (d.ns < 0) *out++ = '-';
+    static constexpr struct {
+        uint64_t scale;
+        char suffix[3];
+    } units[] = {{1'000'000'000, "s"}, {1'000'000, "ms"}, {1'000, "us"}};
+    for (const auto& unit : units) {
+        if (ns < unit.scale) continue;
+        out = write_decimal(out, ns / unit.scale);
+        uint64_t millis = ns % unit.scale / (unit.scale / 1000);
+        if (millis) {
+            *out++ = '.';
+            out = write_padded(out, millis, 3);
+            while (out[-1] == '0') --out;
+        }
+        size_t len = unit.suffix[1] ? 2 : 1;
+        memcpy(out, unit.suffix, len);
+        return out + len;
+    }
+    out = write_decimal(out, ns);
+    memcpy(out, "ns", 2);
+    return out + 2;
+}
+
+inline char* write_time_point(char* out, const TimePoint& tp) {
+    constexpr int64_t NS_PER_DAY = 86'400'000'000'000;
+    int64_t days = tp.ns / NS_PER_DAY;
+    int64_t ns = tp.ns % NS_PER_DAY;
+    if (ns < 0) {
+        ns += NS_PER_DAY;
+        --days;
+    }
+    // Civil date from days since 1970-01-01 (proleptic Gregorian).
+    const int64_t z = days + 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const int64_t doe = z - era * 146097;
+    const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const int64_t mp = (5 * doy + 2) / 153;
+    const int64_t day = doy - (153 * mp + 2) / 5 + 1;
+    const int64_t month = mp < 10 ? mp + 3 : mp - 9;
+    const int64_t year = yoe + era * 400 + (month <= 2);
+    // int64_t nanoseconds only span 1677-2262, so the year is four digits.
+    out = write_padded(out, static_cast<uint64_t>(year), 4);
+    *out++ = '-';
+    out = write_padded(out, static_cast<uint64_t>(month), 2);
+    *out++ = '-';
+    out = write_padded(out, static_cast<uint64_t>(day), 2);
+    *out++ = 'T';
+    const uint64_t secs = static_cast<uint64_t>(ns) / 1'000'000'000;
+    out = write_padded(out, secs / 3600, 2);
+    *out++ = ':';
+    out = write_padded(out, secs / 60 % 60, 2);
+    *out++ = ':';
+    out = write_padded(out, secs % 60, 2);
+    *out++ = '.';
+    out = write_padded(out, static_cast<uint64_t>(ns) % 1'000'000'000, 9);
+    *out++ = 'Z';
+    return out;
+}
+
+inline char* write_ipv4(char* out, const Ipv4& addr) {
+    for (int i = 0; i < 4; ++i) {
+        if (i) *out++ = '.';
+        out = write_decimal(out, addr.bytes[i]);
+    }
+    return out;
+}
+
+inline char* write_ipv6(char* out, const Ipv6& addr) {
+    static constexpr uint8_t MAPPED[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    if (memcmp(addr.bytes, MAPPED, sizeof(MAPPED)) == 0) {
+        memcpy(out, "::ffff:", 7);
+        Ipv4 v4;
+        memcpy(v4.bytes, addr.bytes + 12, 4);
+        return write_ipv4(out + 7, v4);
+    }
+    uint16_t groups[8];
+    for (int i = 0; i < 8; ++i) {
+        groups[i] = static_cast<uint16_t>(addr.bytes[2 * i] << 8 | addr.bytes[2 * i + 1]);
+    }
+    // Longest run of two or more zero groups; the first one on a tie.
+    int best = -1, best_len = 1;
+    for (int i = 0; i < 8;) {
+        int j = i;
+        while (j < 8 && groups[j] == 0) ++j;
+        if (j - i > best_len) {
+            best = i;
+            best_len = j - i;
+        }
+        i = j == i ? i + 1 : j;
+    }
+    static constexpr char hex[] = "0123456789abcdef";
+    for (int i = 0; i < 8;) {
+        if (i == best) {
+            *out++ = ':';
+            *out++ = ':';
+            i += best_len;
+            continue;
+        }
+        if (i && i != best + best_len) *out++ = ':';
+        const uint16_t g = groups[i++];
+        for (int shift = g >= 0x1000 ? 12 : g >= 0x100 ? 8 : g >= 0x10 ? 4 : 0; shift >= 0; shift -= 4) {
+            *out++ = hex[g >> shift & 0xf];
+        }
+    }
+    return out;
+}
+
+inline char* write_uuid(char* out, const Uuid& uuid) {
+    char digits[32];
+#if defined(__SSE2__)
+    // Split each byte into nibbles, interleave them high first, then add
+    // '0', plus the gap up to 'a' for nibbles above 9.
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(uuid.bytes));
+    const __m128i low_nibble = _mm_set1_epi8(0x0f);
+    const __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble);
+    const __m128i lo = _mm_and_si128(bytes, low_nibble);
+    auto to_hex = [](__m128i nibbles) {
+        const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)),
+                                              _mm_set1_epi8('a' - '0' - 10));
+        return _mm_add_epi8(nibbles, _mm_add_epi8(letters, _mm_set1_epi8('0')));
+    };
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digits), to_hex(_mm_unpacklo_epi8(hi, lo)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(digits + 16), to_hex(_mm_unpackhi_epi8(hi, lo)));
+#else
+    static constexpr char hex[] = "0123456789abcdef";
+    for (int i = 0; i < 16; ++i) {
+        digits[2 * i] = hex[uuid.bytes[i] >> 4];
+        digits[2 * i + 1] = hex[uuid.bytes[i] & 0xf];
+    }
+#endif
+    memcpy(out, digits, 8);
+    out[8] = '-';
+    memcpy(out + 9, digits + 8, 4);
+    out[13] = '-';
+    memcpy(out + 14, digits + 12, 4);
+    out[18] = '-';
+    memcpy(out + 19, digits + 16, 4);
+    out[23] = '-';
+    memcpy(out + 24, digits + 20, 12);
+    return out + 36;
+}
+
+// Renders into a stack buffer of MaxSize bytes, then copies to the output.
+// The format spec is a string's, so width and alignment apply: "{:>15}".
+template<typename T, size_t MaxSize, char* (*Write)(char*, const T&)>
+struct FixedFormatter {
+    fmt::formatter<fmt::string_view> text;
+
+    constexpr auto parse(fmt::format_parse_context& ctx) { return text.parse(ctx); }
+
+    template<typename FormatContext>
+    auto format(const T& value, FormatContext& ctx) const {
+        char buf[MaxSize];
+        // formatter<string_view> appends the whole range at once.
+        const char* end = Write(buf, value);
+        return text.format(fmt::string_view(buf, end - buf), ctx);
+    }
+};
+
+} // namespace detail
+
+} // namespace zerolog
+
+template<> struct zerolog::is_trivially_loggable<zerolog::Duration> : std::true_type {};
+template<> struct zerolog::is_trivially_loggable<zerolog::TimePoint> : std::true_type {};
+template<> struct zerolog::is_trivially_loggable<zerolog::Ipv4> : std::true_type {};
+template<> struct zerolog::is_trivially_loggable<zerolog::Ipv6> : std::true_type {};
+template<> struct zerolog::is_trivially_loggable<zerolog::Uuid> : std::true_type {};
+
+template<>
+struct fmt::formatter<zerolog::Duration>
+    : zerolog::detail::FixedFormatter<zerolog::Duration, 32, zerolog::detail::write_duration> {};
+
+template<>
+struct fmt::formatter<zerolog::TimePoint>
+    : zerolog::detail::FixedFormatter<zerolog::TimePoint, 32, zerolog::detail::write_time_point> {};
+
+template<>
+struct fmt::formatter<zerolog::Ipv4>
+    : zerolog::detail::FixedFormatter<zerolog::Ipv4, 16, zerolog::detail::write_ipv4> {};
+
+template<>
+struct fmt::formatter<zerolog::Ipv6>
+    : zerolog::detail::FixedFormatter<zerolog::Ipv6, 48, zerolog::detail::write_ipv6> {};
+
+template<>
+struct fmt::formatter<zerolog::Uuid>
+    : zerolog::detail::FixedFormatter<zerolog::Uuid, 36, zerolog::detail::write_uuid> {};
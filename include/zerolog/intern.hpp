@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "zerolog/codec.hpp"
+
+namespace zerolog {
+
+// Marks a string argument whose values come from a small set: endpoint
+// names, symbols, hostnames. In deferred mode a value this thread has sent
+// before costs a 4-byte id; elsewhere it formats like the string itself.
+// Interned values are kept for the life of the process.
+struct Interned {
+    std::string_view value;
+    operator std::string_view() const { return value; }
+};
+
+inline Interned intern(std::string_view value) { return {value}; }
+
+namespace detail {
+
+// Process-wide id -> string table. Producers find ids through a lock-free
+// per-thread cache and only take the lock on a miss; the consumer reads
+// entries without locking, since a record carrying an id is published after
+// the entry was written.
+class InternTable {
+public:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Producer side: the value's id, or NONE if it is not in the table and
+    // the table is full. Stable for a value, so size() and encode() agree.
+    static uint32_t id_of(std::string_view value) {
+        // Callers usually pass the same buffer again, so the cache is keyed
+        // by address first; the contents are compared either way.
+        thread_local CacheEntry by_address[CACHE_SIZE];
+        CacheEntry& seen = by_address[(reinterpret_cast<uintptr_t>(value.data()) >> 3) % CACHE_SIZE];
+        if (seen.key == reinterpret_cast<uintptr_t>(value.data()) && seen.value == value) {
+            return seen.id;
+        }
+        const size_t hash = std::hash<std::string_view>{}(value);
+        thread_local CacheEntry by_hash[CACHE_SIZE];
+        CacheEntry& entry = by_hash[hash % CACHE_SIZE];
+        uint32_t id = entry.key == hash && entry.value == value ? entry.id : add(value);
+        if (id != NONE) {
+            entry = {hash, id, lookup(id)};
+            seen = {reinterpret_cast<uintptr_t>(value.data()), id, entry.value};
+        }
+        return id;
+    }
+
+    // Consumer side.
+    static std::string_view lookup(uint32_t id) { return chunks_[id / CHUNK][id % CHUNK]; }
+
+private:
+    static constexpr size_t CHUNK = 1024;
+    static constexpr size_t MAX_CHUNKS = 64;
+    static constexpr size_t CACHE_SIZE = 256;
+    struct CacheEntry {
+        uintptr_t key = 0;
+        uint32_t id = NONE;
+        std::string_view value;
+    };
+    static inline std::mutex mtx_;
+    static inline std::deque<std::string> strings_;
+    static inline std::unordered_map<std::string_view, uint32_t> ids_;
+    static inline std::unique_ptr<std::string_view[]> chunks_[MAX_CHUNKS];
+
+    static uint32_t add(std::string_view value) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        auto it = ids_.find(value);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        const size_t id = strings_.size();
+        if (id == CHUNK * MAX_CHUNKS) {
+            return NONE;
+        }
+        if (id % CHUNK == 0) {
+            chunks_[id / CHUNK] = std::make_unique<std::string_view[]>(CHUNK);
+        }
+        std::string_view stored = strings_.emplace_back(value);
+        chunks_[id / CHUNK][id % CHUNK] = stored;
+        ids_.emplace(stored, static_cast<uint32_t>(id));
+        return static_cast<uint32_t>(id);
+    }
+};
+
+} // namespace detail
+
+// [uint32_t id], or NONE followed by the string when the table is full.
+template<>
+struct codec<Interned> {
+    static size_t size(const Interned& s) {
+        uint32_t id = detail::InternTable::id_of(s.value);
+        return sizeof(id) + (id == detail::InternTable::NONE ? codec<std::string_view>::size(s.value) : 0);
+    }
+    static char* encode(char* out, const Interned& s) {
+        uint32_t id = detail::InternTable::id_of(s.value);
+        memcpy(out, &id, sizeof(id));
+        out += sizeof(id);
+        return id == detail::InternTable::NONE ? codec<std::string_view>::encode(out, s.value) : out;
+    }
+    static std::string_view decode(const char*& in) {
+        uint32_t id;
+        memcpy(&id, in, sizeof(id));
+        in += sizeof(id);
+        return id == detail::InternTable::NONE ? codec<std::string_view>::decode(in)
+                                               : detail::InternTable::lookup(id);
+    }
+};
+
+} // namespace zerolog
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <fmt/core.h>
+
+namespace zerolog {
+
+enum class LogLevel : uint8_t {
+    TRACE, DEBUG, INFO, WARN, ERROR, CRITICAL
+};
+
+// Deferred mode (see codec.hpp) copies the bytes of types marked here:
+// arithmetic types and enums, whose bytes are their whole value. Other
+// trivially copyable types opt in by specializing this to true_type. Never
+// opt in a type that points at memory the caller owns (fmt::string_view,
+// spans, T*, structs holding them): the consumer would read it after the
+// call has returned.
+template<typename T>
+struct is_trivially_loggable : std::bool_constant<std::is_arithmetic_v<T> || std::is_enum_v<T>> {};
+
+template<typename T>
+inline constexpr bool is_trivially_loggable_v = is_trivially_loggable<T>::value;
+
+// Categories are tag types carrying their compile-time threshold:
+//
+//   namespace cat {
+//   struct net { static constexpr LogLevel min_level = LogLevel::DEBUG; };
+//   }
+//   logger.debug<cat::net>("{} bytes in", n);
+//
+// A categorized call below its category's min_level compiles away, whatever
+// the logger's MinLevel; one that passes is checked against the category's
+// runtime level (a relaxed atomic load), which starts at min_level.
+namespace detail {
+
+template<typename Category>
+inline std::atomic<LogLevel> category_level{Category::min_level};
+
+} // namespace detail
+
+// Levels below the category's min_level stay compiled out.
+template<typename Category>
+void set_category_level(LogLevel level) {
+    detail::category_level<Category>.store(level, std::memory_order_relaxed);
+}
+
+template<typename Category>
+bool category_enabled(LogLevel level) {
+    return level >= detail::category_level<Category>.load(std::memory_order_relaxed);
+}
+
+// Front end for translation units that only log: pulls in <fmt/core.h> and
+// <atomic> only. The logger is built where logger.hpp is included and handed
+// out with Logger::ref(). Calls made through a LogRef check the level at run
+// time and are always formatted on the calling thread (no deferred mode).
+class LogRef {
+public:
+    using VLog = void (*)(void* logger, LogLevel level, fmt::string_view fmt, fmt::format_args args);
+    using Flush = void (*)(void* logger);
+
+    LogRef(void* logger, LogLevel min_level, VLog vlog, Flush flush)
+        : logger_(logger), vlog_(vlog), flush_(flush), min_level_(min_level) {}
+
+    template<typename... Args> void trace(fmt::format_string<Args...> fmt, Args&&... args){log(LogLevel::TRACE, fmt, args...);}
+    template<typename... Args> void debug(fmt::format_string<Args...> fmt, Args&&... args){log(LogLevel::DEBUG, fmt, args...);}
+    template<typename... Args> void info(fmt::format_string<Args...> fmt, Args&&... args){log(LogLevel::INFO, fmt, args...);}
+    template<typename... Args> void warn(fmt::format_string<Args...> fmt, Args&&... args){log(LogLevel::WARN, fmt, args...);}
+    template<typename... Args> void error(fmt::format_string<Args...> fmt, Args&&... args){log(LogLevel::ERROR, fmt, args...);}
+    template<typename... Args> void critical(fmt::format_string<Args...> fmt, Args&&... args){log(LogLevel::CRITICAL, fmt, args...);}
+
+    template<typename Category, typename... Args> void trace(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::TRACE, Category>(fmt, args...);}
+    template<typename Category, typename... Args> void debug(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::DEBUG, Category>(fmt, args...);}
+    template<typename Category, typename... Args> void info(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::INFO, Category>(fmt, args...);}
+    template<typename Category, typename... Args> void warn(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::WARN, Category>(fmt, args...);}
+    template<typename Category, typename... Args> void error(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::ERROR, Category>(fmt, args...);}
+    template<typename Category, typename... Args> void critical(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::CRITICAL, Category>(fmt, args...);}
+
+    void flush() { flush_(logger_); }
+
+private:
+    void* logger_;
+    VLog vlog_;
+    Flush flush_;
+    LogLevel min_level_;
+
+    template<typename... Args>
+    void log(LogLevel level, fmt::string_view fmt, const Args&... args) {
+        if (level >= min_level_) {
+            vlog_(logger_, level, fmt, fmt::make_format_args(args...));
+        }
+    }
+
+    template<LogLevel L, typename Category, typename... Args>
+    void log(fmt::string_view fmt, const Args&... args) {
+        if constexpr (L >= Category::min_level) {
+            if (category_enabled<Category>(L)) {
+                vlog_(logger_, L, fmt, fmt::make_format_args(args...));
+            }
+        }
+    }
+};
+
+} // namespace zerolog
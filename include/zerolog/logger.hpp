@@ -1,5 +1,12 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <exception>
+#include <system_error>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
@@ -8,32 +15,186 @@
 #include <vector>
 #include <cstring>
 #include <memory>  // ✅ For std::shared_ptr
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "zerolog/codec.hpp"
+#include "zerolog/core_registry.hpp"
+#include "zerolog/log.hpp"
+#include "zerolog/numa.hpp"
+#include "zerolog/ring_file.hpp"
+#include "zerolog/rseq.hpp"
+#include "zerolog/sink_traits.hpp"
+#include "zerolog/spill_file.hpp"
+#include "zerolog/wait_strategy.hpp"
+#include "zerolog/worker_options.hpp"
+#include <climits>
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 namespace zerolog {
 
-enum class LogLevel : uint8_t {
-    TRACE, DEBUG, INFO, WARN, ERROR, CRITICAL
+enum class LogMode : uint8_t {
+    SYNC,    // format and write on the calling thread
+    CONCURRENT_SYNC, // per-thread line buffers, each emitted with one write(2) to the sink's fd();
+                     // a thread-safe sink is written to directly
+    ASYNC,   // dedicated worker thread drains the queue
+    MANUAL   // no worker; the application calls drain() from its own loop
+};
+
+enum class OverflowPolicy : uint8_t {
+    BLOCK, // the producer waits for the consumer to make room
+    DROP,  // the record is discarded and counted in dropped()
+    SPILL  // the record goes to a spill file, replayed after the thread's queued records
+};
+
+enum class QueueTopology : uint8_t {
+    SHARED,        // one ring for every producer
+    PER_NUMA_NODE, // one ring per NUMA node, merged by timestamp on the consumer
+    PER_CPU        // one ring per CPU, committed with rseq instead of a CAS
+};
+
+struct LoggerOptions {
+    LogMode mode = LogMode::SYNC;
+    size_t queue_capacity = 65536;  // total entries, split across per-node/per-CPU rings
+    QueueTopology topology = QueueTopology::SHARED;
+    // How long the worker holds a record so that older records still in
+    // flight on other queues can be merged ahead of it. 0 merges the heads
+    // visible as each record is written; a thread's own records keep their
+    // order either way.
+    std::chrono::nanoseconds reorder_window{0};
+    // Rings that stay nearly full grow (doubling, up to this many entries
+    // each) and go back to their original size after shrink_after of near
+    // idleness. 0 keeps capacity fixed. Not applied to rseq-committed or
+    // single-producer rings.
+    size_t max_queue_capacity = 0;
+    std::chrono::milliseconds shrink_after{10000};
+    OverflowPolicy overflow = OverflowPolicy::BLOCK;
+    // Elastic mode: a producer whose ring is full queues records in its own
+    // chain of pooled chunks, up to this many bytes across all producers;
+    // past that, `overflow` applies. 0 disables.
+    size_t elastic_memory_cap = 0;
+    std::string spill_path;  // SPILL only; empty uses an unnamed file in /tmp
+    // ASYNC/MANUAL: calls whose arguments all have a codec<T> are encoded on
+    // the producer and formatted on the consumer.
+    bool deferred = false;
+    // ASYNC/MANUAL: keep the ring in this file (see RingFile) so that records
+    // not yet written when the process is killed can be recovered with
+    // zerolog_recover. Implies one shared ring of fixed capacity and no
+    // deferred formatting; the sink is flushed after every burst. Records a
+    // previous process left in the file are written first. Only the SHARED
+    // topology without elastic_memory_cap or SPILL is allowed, since records
+    // anywhere but the file would not survive; the constructor throws otherwise.
+    std::string persistent_path;
+    WorkerOptions worker;
 };
 
 struct alignas(64) PaddedAtomicSizeT {
     std::atomic<size_t> value{0};
 };
 
-class LockFreeRingBuffer {
+// Producer policies for BasicRingBuffer and Logger.
+struct MultiProducer {};   // any number of threads enqueue; tail_ is claimed with a CAS
+struct SingleProducer {};  // exactly one thread enqueues; tail_ is a plain release store
+
+template<typename Producers>
+class BasicRingBuffer {
+    static constexpr bool SINGLE_PRODUCER = std::is_same_v<Producers, SingleProducer>;
+
+public:
+    // Slot layout: [payload | uint64_t timestamp | uint16_t length]. A zero
+    // length marks a slot that is free or reserved but not yet published.
+    static constexpr size_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(uint16_t);
+    // Set in tail_ by seal(); producers then fail without reserving.
+    static constexpr size_t SEALED = size_t{1} << (sizeof(size_t) * 8 - 1);
+
 private:
     static constexpr size_t CACHE_LINE_SIZE = 64;
     alignas(CACHE_LINE_SIZE) PaddedAtomicSizeT head_;
+    mutable size_t cached_tail_ = 0;  // SingleProducer: consumer's last view of tail_
+    size_t read_ = 0;                 // consumer's next record; ahead of head_ until release()
+    std::atomic<uint64_t>* durable_head_ = nullptr;  // persistent rings only
     alignas(CACHE_LINE_SIZE) PaddedAtomicSizeT tail_;
+    size_t cached_head_ = 0;          // SingleProducer: producer's last view of head_
+    // Debug builds record the SingleProducer thread here. The member exists in
+    // every build so the layout does not depend on NDEBUG: libzerolog.a may be
+    // built with it and the application without.
+    std::atomic<std::thread::id> producer_{};
     std::unique_ptr<char[]> buffer_;
     void* aligned_buffer_ = nullptr;
     const size_t buffer_size_;
     const size_t entry_size_;
     const size_t max_entries_;
+    detail::CoreRegion core_region_;
+
+    // Publishes the slots for zerolog_core_extract. Persistent rings are
+    // left out: their shared file mapping is not in a core by default, and
+    // zerolog_recover reads the file itself.
+    void register_core_region() {
+        core_region_.kind = detail::CoreRegion::RING;
+        core_region_.slots = reinterpret_cast<uintptr_t>(aligned_buffer_);
+        core_region_.entry_size = entry_size_;
+        core_region_.capacity = max_entries_;
+        core_region_.head = reinterpret_cast<uintptr_t>(&head_.value);
+        core_region_.tail = reinterpret_cast<uintptr_t>(&tail_.value);
+        detail::core_register(core_region_);
+    }
+
+    char* slot_at(size_t seq) const {
+        return static_cast<char*>(aligned_buffer_) + ((seq % max_entries_) * entry_size_);
+    }
+
+    // Waits for the producer that reserved the head slot to publish it.
+    uint16_t published_length(const char* slot) const {
+        uint16_t slot_len;
+        while ((slot_len = __atomic_load_n(reinterpret_cast<const uint16_t*>(slot + entry_size_ - 2),
+                                           __ATOMIC_ACQUIRE)) == 0) {
+            std::this_thread::yield();
+        }
+        return slot_len;
+    }
+
+    // Consumer side: whether a record has been reserved at `head`. With a
+    // single producer, tail_ is only re-read once the cached copy runs out.
+    bool readable(size_t head) const {
+        if constexpr (SINGLE_PRODUCER) {
+            if (head < cached_tail_) return true;
+            cached_tail_ = tail_sequence();
+            return head < cached_tail_;
+        } else {
+            return head < tail_sequence();
+        }
+    }
+
+    bool try_enqueue_single(const void* data, size_t len, uint64_t timestamp) {
+#ifndef NDEBUG
+        std::thread::id expected{};
+        if (!producer_.compare_exchange_strong(expected, std::this_thread::get_id())) {
+            assert(expected == std::this_thread::get_id() && "SingleProducer ring written by two threads");
+        }
+#endif
+        size_t current_tail = tail_.value.load(std::memory_order_relaxed);
+        if (current_tail - cached_head_ >= max_entries_) {
+            cached_head_ = head_.value.load(std::memory_order_acquire);
+            if (current_tail - cached_head_ >= max_entries_) {
+                return false;
+            }
+        }
+        char* slot = slot_at(current_tail);
+        memcpy(slot, data, len);
+        memcpy(slot + entry_size_ - TRAILER_SIZE, &timestamp, sizeof(timestamp));
+        __atomic_store_n(reinterpret_cast<uint16_t*>(slot + entry_size_ - 2),
+                         static_cast<uint16_t>(len), __ATOMIC_RELAXED);
+        tail_.value.store(current_tail + 1, std::memory_order_release);
+        return true;
+    }
 
 public:
-    explicit LockFreeRingBuffer(size_t entry_size, size_t max_entries)
-        : entry_size_(entry_size), max_entries_(max_entries), 
-          buffer_size_(entry_size * max_entries) {
+    explicit BasicRingBuffer(size_t entry_size, size_t max_entries)
+        : buffer_size_(entry_size * max_entries), entry_size_(entry_size), max_entries_(max_entries) {
         size_t allocation_size = buffer_size_ + 64;
         buffer_ = std::make_unique<char[]>(allocation_size);
         void* ptr = buffer_.get();
@@ -42,14 +203,36 @@ public:
         if (!aligned_buffer_) {
             throw std::runtime_error("Buffer alignment failed");
         }
+        register_core_region();
+    }
+
+    BasicRingBuffer(const BasicRingBuffer&) = delete;
+    BasicRingBuffer& operator=(const BasicRingBuffer&) = delete;
+
+    ~BasicRingBuffer() {
+        if (buffer_) {
+            detail::core_unregister(core_region_);
+        }
+    }
+
+    // Slots live in a freshly reset RingFile, which must outlive the ring.
+    // Dequeued records keep their slots until release().
+    BasicRingBuffer(size_t entry_size, size_t max_entries, RingFile& file)
+        : buffer_size_(entry_size * max_entries), entry_size_(entry_size), max_entries_(max_entries) {
+        static_assert(RingFile::TRAILER_SIZE == TRAILER_SIZE);
+        aligned_buffer_ = file.slots();
+        durable_head_ = &file.head();
     }
 
-    bool try_enqueue(const void* data, size_t len) {
+    bool try_enqueue(const void* data, size_t len, uint64_t timestamp = 0) {
+        if constexpr (SINGLE_PRODUCER) {
+            return try_enqueue_single(data, len, timestamp);
+        }
         size_t current_tail = tail_.value.load(std::memory_order_relaxed);
         size_t next_tail;
-        int backoff = 0;
         do {
-            if ((current_tail - head_.value.load(std::memory_order_acquire)) >= max_entries_) {
+            if ((current_tail & SEALED) ||
+                (current_tail - head_.value.load(std::memory_order_acquire)) >= max_entries_) {
                 return false;
             }
             next_tail = current_tail + 1;
@@ -58,38 +241,288 @@ public:
             std::memory_order_acq_rel,
             std::memory_order_relaxed));
         
-        char* slot = static_cast<char*>(aligned_buffer_) + ((current_tail % max_entries_) * entry_size_);
+        char* slot = slot_at(current_tail);
         memcpy(slot, data, len);
-        *reinterpret_cast<uint16_t*>(slot + entry_size_ - 2) = static_cast<uint16_t>(len);
+        memcpy(slot + entry_size_ - TRAILER_SIZE, &timestamp, sizeof(timestamp));
+        __atomic_store_n(reinterpret_cast<uint16_t*>(slot + entry_size_ - 2),
+                         static_cast<uint16_t>(len), __ATOMIC_RELEASE);
         return true;
     }
 
     bool try_dequeue(void* data, size_t& len) {
-        size_t current_head = head_.value.load(std::memory_order_relaxed);
-        if (current_head >= tail_.value.load(std::memory_order_acquire)) {
+        size_t current_head = read_;
+        if (!readable(current_head)) {
             return false;
         }
         
-        char* slot = static_cast<char*>(aligned_buffer_) + ((current_head % max_entries_) * entry_size_);
-        uint16_t slot_len;
-        while ((slot_len = *reinterpret_cast<volatile uint16_t*>(slot + entry_size_ - 2)) == 0) {
-            std::this_thread::yield();
-        }
-        
-        len = slot_len;
+        char* slot = slot_at(current_head);
+        len = published_length(slot);
         memcpy(data, slot, len);
-        *reinterpret_cast<uint16_t*>(slot + entry_size_ - 2) = 0;
-        head_.value.store(current_head + 1, std::memory_order_release);
+        read_ = current_head + 1;
+        if (!durable_head_) {
+            __atomic_store_n(reinterpret_cast<uint16_t*>(slot + entry_size_ - 2), uint16_t{0}, __ATOMIC_RELAXED);
+            head_.value.store(read_, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Consumer side, persistent rings: once everything dequeued so far has
+    // reached the sink and been flushed, hands the slots back to producers.
+    // The durable head moves first so that a reused slot is never read as
+    // belonging to the old lap.
+    void release() {
+        size_t head = head_.value.load(std::memory_order_relaxed);
+        if (!durable_head_ || head == read_) {
+            return;
+        }
+        for (; head < read_; ++head) {
+            __atomic_store_n(reinterpret_cast<uint16_t*>(slot_at(head) + entry_size_ - 2), uint16_t{0},
+                             __ATOMIC_RELAXED);
+        }
+        durable_head_->store(read_, std::memory_order_release);
+        head_.value.store(read_, std::memory_order_release);
+    }
+
+    // Consumer side: timestamp of the oldest record without removing it.
+    bool peek_timestamp(uint64_t& timestamp) const {
+        size_t current_head = read_;
+        if (!readable(current_head)) {
+            return false;
+        }
+        const char* slot = slot_at(current_head);
+        published_length(slot);
+        memcpy(&timestamp, slot + entry_size_ - TRAILER_SIZE, sizeof(timestamp));
         return true;
     }
 
     size_t size() const {
-        return tail_.value.load(std::memory_order_acquire) - 
-               head_.value.load(std::memory_order_acquire);
+        size_t head = head_.value.load(std::memory_order_acquire);
+        return tail_sequence() - head;
+    }
+
+#if ZEROLOG_HAS_RSEQ
+    enum class CpuEnqueue { OK, FULL, RETRY };
+
+    // Producer side for a ring owned by one CPU: copies a whole slot image
+    // (payload and trailer) and publishes it with a plain store to tail
+    // inside an rseq critical section. Never mix with try_enqueue on the
+    // same ring: rseq is only atomic against threads on the same CPU.
+    CpuEnqueue try_enqueue_on_cpu(int cpu, const char* image) {
+        size_t current_tail = tail_.value.load(std::memory_order_relaxed);
+        if (current_tail - head_.value.load(std::memory_order_acquire) >= max_entries_) {
+            return CpuEnqueue::FULL;
+        }
+        bool committed = detail::rseq_copy_and_commit(
+            cpu, reinterpret_cast<size_t*>(&tail_.value), current_tail, current_tail + 1,
+            slot_at(current_tail), image, entry_size_);
+        return committed ? CpuEnqueue::OK : CpuEnqueue::RETRY;
     }
+#endif
 
+    // Consumer side: the next record to dequeue.
+    size_t head_sequence() const { return durable_head_ ? read_ : head_.value.load(std::memory_order_acquire); }
+    size_t tail_sequence() const { return tail_.value.load(std::memory_order_acquire) & ~SEALED; }
+    size_t max_payload() const { return entry_size_ - TRAILER_SIZE; }
+    size_t capacity() const { return max_entries_; }
     bool empty() const { return size() == 0; }
     bool full() const { return size() >= max_entries_; }
+
+    // Stops further enqueues; returns the sequence the ring ends at. Only for
+    // multi-producer rings committed with try_enqueue: rseq commits and
+    // single-producer stores do not see the bit.
+    size_t seal() { return tail_.value.fetch_or(SEALED, std::memory_order_acq_rel) & ~SEALED; }
+    bool sealed() const { return tail_.value.load(std::memory_order_acquire) & SEALED; }
+
+    // Before the ring is shared: continue the sequence of a sealed predecessor.
+    void start_at(size_t sequence) {
+        head_.value.store(sequence, std::memory_order_relaxed);
+        tail_.value.store(sequence, std::memory_order_relaxed);
+        cached_head_ = cached_tail_ = read_ = sequence;
+    }
+
+    // Once a sealed ring has been drained nothing touches its slots again.
+    void release_storage() {
+        if (buffer_) {
+            detail::core_unregister(core_region_);
+        }
+        buffer_.reset();
+        aligned_buffer_ = nullptr;
+    }
+};
+
+using LockFreeRingBuffer = BasicRingBuffer<MultiProducer>;
+
+namespace detail {
+
+// Tells the consumer when no producer can still hold a pointer to a ring it
+// replaced. For the length of a ring operation a producer keeps the epoch it
+// started at in its thread's slot (0 when idle); a ring retired at epoch E
+// can be freed once no slot holds an epoch below E.
+class RingEpoch {
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0};
+
+        Slot() {
+            std::lock_guard<std::mutex> lock(registry_mtx());
+            registry().push_back(this);
+        }
+        ~Slot() {
+            std::lock_guard<std::mutex> lock(registry_mtx());
+            auto& slots = registry();
+            slots.erase(std::find(slots.begin(), slots.end(), this));
+        }
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+    };
+
+    static std::mutex& registry_mtx() {
+        static std::mutex mtx;
+        return mtx;
+    }
+    static std::vector<Slot*>& registry() {
+        static std::vector<Slot*> slots;
+        return slots;
+    }
+
+    static inline std::atomic<uint64_t> current_{1};
+    thread_local static inline Slot slot_;
+
+public:
+    // Producer side, around every use of a ring pointer the consumer may
+    // retire. Does nothing unless `enabled`; never nested.
+    class Guard {
+        Slot* slot_;
+
+    public:
+        explicit Guard(bool enabled) : slot_(enabled ? &RingEpoch::slot_ : nullptr) {
+            if (slot_) {
+                slot_->epoch.store(current_.load(std::memory_order_acquire), std::memory_order_relaxed);
+                // Pairs with the fence in quiescent(): either the consumer sees
+                // this slot, or the ring pointer loaded next is the new one.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+        ~Guard() {
+            if (slot_) slot_->epoch.store(0, std::memory_order_release);
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    // Consumer side, after publishing a replacement: the epoch the old ring
+    // is retired at.
+    static uint64_t advance() { return current_.fetch_add(1, std::memory_order_acq_rel) + 1; }
+
+    // Consumer side: whether every producer that may have seen a ring
+    // retired at `epoch` is done with it.
+    static bool quiescent(uint64_t epoch) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::lock_guard<std::mutex> lock(registry_mtx());
+        for (const Slot* slot : registry()) {
+            const uint64_t seen = slot->epoch.load(std::memory_order_acquire);
+            if (seen != 0 && seen < epoch) return false;
+        }
+        return true;
+    }
+};
+
+} // namespace detail
+
+// A ring the consumer can replace with a larger or smaller one. The current
+// ring is sealed at some sequence and its successor starts there, so sequence
+// numbers stay continuous; producers that find the ring sealed move on to the
+// successor while the consumer finishes the old one. A retired ring gives
+// back its storage once drained and is freed once detail::RingEpoch shows no
+// producer can still be reading it.
+template<typename Ring>
+class ResizableRing {
+    std::atomic<Ring*> active_;
+    Ring* draining_ = nullptr;
+    std::unique_ptr<Ring> current_;
+    std::vector<std::pair<std::unique_ptr<Ring>, uint64_t>> retired_;  // with the epoch retired at
+    bool guarded_ = false;
+
+    Ring* active() const { return active_.load(std::memory_order_acquire); }
+
+    // Consumer side: the sealed ring until it is drained, then its successor.
+    Ring& consumer_ring() {
+        if (draining_) {
+            if (draining_->head_sequence() < draining_->tail_sequence()) {
+                return *draining_;
+            }
+            draining_->release_storage();
+            draining_ = nullptr;
+        }
+        return *active();
+    }
+
+public:
+    explicit ResizableRing(std::unique_ptr<Ring> ring) : active_(ring.get()), current_(std::move(ring)) {}
+
+    // Before the ring is shared: producers are tracked from now on, which
+    // resize() requires.
+    void enable_resize() { guarded_ = true; }
+
+    bool try_enqueue(const void* data, size_t len, uint64_t timestamp) {
+        detail::RingEpoch::Guard guard(guarded_);
+        for (;;) {
+            Ring* ring = active();
+            if (ring->try_enqueue(data, len, timestamp)) return true;
+            if (!ring->sealed()) return false;
+        }
+    }
+
+#if ZEROLOG_HAS_RSEQ
+    typename Ring::CpuEnqueue try_enqueue_on_cpu(int cpu, const char* image) {
+        return active()->try_enqueue_on_cpu(cpu, image);
+    }
+#endif
+
+    bool try_dequeue(void* data, size_t& len) { return consumer_ring().try_dequeue(data, len); }
+    void release() { consumer_ring().release(); }
+    bool peek_timestamp(uint64_t& timestamp) { return consumer_ring().peek_timestamp(timestamp); }
+
+    // Consumer side: redirects producers to `next`. One resize at a time.
+    void resize(std::unique_ptr<Ring> next) {
+        assert(guarded_);
+        next->start_at(current_->seal());
+        draining_ = current_.get();
+        active_.store(next.get(), std::memory_order_release);
+        retired_.emplace_back(std::move(current_), detail::RingEpoch::advance());
+        current_ = std::move(next);
+    }
+    bool resizing() {
+        consumer_ring();
+        reclaim();
+        return draining_ != nullptr;
+    }
+
+    // Consumer side: frees retired rings that are drained and that no
+    // producer can still be using.
+    void reclaim() {
+        retired_.erase(std::remove_if(retired_.begin(), retired_.end(),
+                                      [this](const auto& retired) {
+                                          return retired.first.get() != draining_ &&
+                                                 detail::RingEpoch::quiescent(retired.second);
+                                      }),
+                       retired_.end());
+    }
+
+    size_t head_sequence() const { return (draining_ ? draining_ : active())->head_sequence(); }
+    size_t tail_sequence() const {
+        detail::RingEpoch::Guard guard(guarded_);
+        return active()->tail_sequence();
+    }
+    size_t size() const {
+        size_t head = head_sequence();
+        return tail_sequence() - head;
+    }
+    size_t capacity() const { return active()->capacity(); }
+    bool empty() const { return size() == 0; }
+    bool full() const {
+        detail::RingEpoch::Guard guard(guarded_);
+        return active()->full();
+    }
 };
 
 class ThreadLocalBatch {
@@ -99,148 +532,1665 @@ private:
     std::array<char, ENTRY_SIZE * BATCH_SIZE> batch_;
     size_t count_ = 0;
     const size_t entry_size_;
+    detail::CoreRegion core_region_;
 
 public:
-    ThreadLocalBatch() : entry_size_(ENTRY_SIZE) {}
+    // Registered for zerolog_core_extract for as long as the thread lives.
+    ThreadLocalBatch() : entry_size_(ENTRY_SIZE) {
+        core_region_.kind = detail::CoreRegion::BATCH;
+        core_region_.slots = reinterpret_cast<uintptr_t>(batch_.data());
+        core_region_.entry_size = ENTRY_SIZE;
+        core_region_.capacity = BATCH_SIZE;
+        core_region_.tail = reinterpret_cast<uintptr_t>(&count_);
+        detail::core_register(core_region_);
+    }
+    ~ThreadLocalBatch() { detail::core_unregister(core_region_); }
+
+    ThreadLocalBatch(const ThreadLocalBatch&) = delete;
+    ThreadLocalBatch& operator=(const ThreadLocalBatch&) = delete;
     
-    bool try_add(const void* data, size_t len) {
+    // Same slot layout as LockFreeRingBuffer; oversized records are cut.
+    bool try_add(const void* data, size_t len, uint64_t timestamp = 0) {
         if (count_ >= BATCH_SIZE) return false;
         char* slot = &batch_[count_ * entry_size_];
-        memcpy(slot, data, std::min(len, entry_size_ - 2));
+        len = std::min(len, entry_size_ - LockFreeRingBuffer::TRAILER_SIZE);
+        memcpy(slot, data, len);
+        memcpy(slot + entry_size_ - LockFreeRingBuffer::TRAILER_SIZE, &timestamp, sizeof(timestamp));
         *reinterpret_cast<uint16_t*>(slot + entry_size_ - 2) = static_cast<uint16_t>(len);
         ++count_;
         return true;
     }
 
     const char* operator[](size_t idx) const { return &batch_[idx * entry_size_]; }
+    size_t length(size_t idx) const {
+        return *reinterpret_cast<const uint16_t*>(&batch_[idx * entry_size_ + entry_size_ - 2]);
+    }
+    uint64_t timestamp(size_t idx) const {
+        uint64_t ts;
+        memcpy(&ts, &batch_[idx * entry_size_ + entry_size_ - LockFreeRingBuffer::TRAILER_SIZE], sizeof(ts));
+        return ts;
+    }
     size_t size() const { return count_; }
     void clear() { count_ = 0; }
 };
 
-template<typename Sink, LogLevel MinLevel = LogLevel::TRACE>
-class Logger {
-private:
-    Sink sink_;
-    std::unique_ptr<LockFreeRingBuffer> queue_;
-    std::unique_ptr<std::thread> worker_;
-    std::mutex mtx_;
-    std::condition_variable cv_;
-    std::atomic<bool> running_{true};
-    static constexpr size_t BACKOFF_MAX = 4;
-    thread_local static inline fmt::memory_buffer format_buf_;
-    thread_local static inline ThreadLocalBatch batch_;
-    
-    void worker_loop() {
-        char entry[256];
-        size_t len;
-        while (running_.load(std::memory_order_acquire)) {
-            if (queue_->try_dequeue(entry, len)) {
-                sink_.write({entry, len});
-            } else {
-                std::unique_lock<std::mutex> lock(mtx_);
-                cv_.wait_for(lock, std::chrono::microseconds(100));
-            }
+// Fixed-size chunks for ElasticQueue. Drained chunks go back on a free list,
+// so once a burst has grown the pool later bursts do not allocate. The lock
+// is taken once per chunk, never per record.
+class ChunkPool {
+public:
+    static constexpr size_t ENTRY_SIZE = 256;
+    static constexpr size_t CHUNK_ENTRIES = 64;
+
+    struct Chunk {
+        char slots[ENTRY_SIZE * CHUNK_ENTRIES];
+        Chunk* next = nullptr;
+    };
+
+    explicit ChunkPool(size_t memory_cap)
+        : max_chunks_(std::max<size_t>(memory_cap / sizeof(Chunk), 1)) {}
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+
+    ~ChunkPool() {
+        while (free_) {
+            delete std::exchange(free_, free_->next);
         }
-        while (queue_->try_dequeue(entry, len)) {
-            sink_.write({entry, len});
+    }
+
+    // nullptr once the memory cap is reached and nothing has been recycled.
+    Chunk* acquire() {
+        std::lock_guard<std::mutex> lock(mtx_);
+        Chunk* chunk = free_;
+        if (chunk) {
+            free_ = chunk->next;
+        } else if (allocated_ < max_chunks_) {
+            chunk = new (std::nothrow) Chunk;
+            if (!chunk) return nullptr;
+            ++allocated_;
+        } else {
+            return nullptr;
         }
+        chunk->next = nullptr;
+        return chunk;
     }
 
-    void flush_batch() {
-        for (size_t i = 0; i < batch_.size(); ++i) {
-            const char* data = batch_[i];
-            size_t len = *reinterpret_cast<const uint16_t*>(data + 254);
-            int backoff = 0;
-            while (!queue_->try_enqueue(data, len)) {
-                if (backoff < BACKOFF_MAX) {
-                    for (int j = 0; j < (1 << backoff); ++j) {
-                        std::this_thread::yield();
-                    }
-                    ++backoff;
-                } else {
-                    std::this_thread::sleep_for(std::chrono::nanoseconds(100));
-                }
-            }
+    void release(Chunk* chunk) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        chunk->next = free_;
+        free_ = chunk;
+    }
+
+    bool exhausted() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return !free_ && allocated_ >= max_chunks_;
+    }
+
+private:
+    mutable std::mutex mtx_;
+    Chunk* free_ = nullptr;
+    size_t allocated_ = 0;
+    const size_t max_chunks_;
+};
+
+// Single-producer/single-consumer queue of linked chunks holding the records
+// one thread could not fit in its ring, in LockFreeRingBuffer's slot layout.
+// The consumer hands each chunk back to the pool once it has moved past it.
+class ElasticQueue {
+    using Chunk = ChunkPool::Chunk;
+    static constexpr size_t ENTRY_SIZE = ChunkPool::ENTRY_SIZE;
+    static constexpr size_t CHUNK_ENTRIES = ChunkPool::CHUNK_ENTRIES;
+
+    alignas(64) PaddedAtomicSizeT head_;
+    alignas(64) PaddedAtomicSizeT tail_;
+    ChunkPool& pool_;
+    Chunk* head_chunk_;       // consumer
+    size_t head_chunk_base_ = 0;
+    Chunk* tail_chunk_;       // producer
+    // Published by the tail_ store of the push that follows set_barrier().
+    std::atomic<size_t> barrier_ring_{0};
+    std::atomic<size_t> barrier_sequence_{0};
+
+    // Consumer side: the head slot, stepping onto the next chunk if needed.
+    const char* front() {
+        size_t current_head = head_.value.load(std::memory_order_relaxed);
+        if (current_head == tail_.value.load(std::memory_order_acquire)) {
+            return nullptr;
         }
-        batch_.clear();
-        if (batch_.size() > 0) {
-            std::lock_guard<std::mutex> lock(mtx_);
-            cv_.notify_one();
+        if (current_head - head_chunk_base_ == CHUNK_ENTRIES) {
+            Chunk* next = head_chunk_->next;
+            pool_.release(head_chunk_);
+            head_chunk_ = next;
+            head_chunk_base_ = current_head;
         }
+        return head_chunk_->slots + (current_head - head_chunk_base_) * ENTRY_SIZE;
     }
 
 public:
-    explicit Logger(Sink sink = {}, bool async = false) 
-        : sink_(std::move(sink)) {
-        if (async) {
-            queue_ = std::make_unique<LockFreeRingBuffer>(256, 65536);
-            worker_ = std::make_unique<std::thread>(&Logger::worker_loop, this);
+    ElasticQueue(ChunkPool& pool, Chunk* first)
+        : pool_(pool), head_chunk_(first), tail_chunk_(first) {}
+    ElasticQueue(const ElasticQueue&) = delete;
+    ElasticQueue& operator=(const ElasticQueue&) = delete;
+
+    ~ElasticQueue() {
+        while (head_chunk_) {
+            pool_.release(std::exchange(head_chunk_, head_chunk_->next));
         }
     }
-    
-    ~Logger() {
-        if (worker_) {
-            running_ = false;
-            cv_.notify_all();
-            worker_->join();
+
+    // Producer side: copies a slot image; false if a new chunk is needed and
+    // the pool is exhausted.
+    bool try_push(const char* image) {
+        size_t current_tail = tail_.value.load(std::memory_order_relaxed);
+        size_t index = current_tail % CHUNK_ENTRIES;
+        if (index == 0 && current_tail != 0) {
+            Chunk* chunk = pool_.acquire();
+            if (!chunk) return false;
+            tail_chunk_->next = chunk;
+            tail_chunk_ = chunk;
         }
-        flush();
+        char* slot = tail_chunk_->slots + index * ENTRY_SIZE;
+        uint16_t len;
+        memcpy(&len, image + ENTRY_SIZE - sizeof(len), sizeof(len));
+        memcpy(slot, image, len);
+        memcpy(slot + ENTRY_SIZE - LockFreeRingBuffer::TRAILER_SIZE,
+               image + ENTRY_SIZE - LockFreeRingBuffer::TRAILER_SIZE, LockFreeRingBuffer::TRAILER_SIZE);
+        tail_.value.store(current_tail + 1, std::memory_order_release);
+        return true;
     }
 
-    template<LogLevel L, typename... Args>
-    void log(fmt::format_string<Args...> fmt, Args&&... args) {
-        if constexpr (static_cast<int>(L) >= static_cast<int>(MinLevel)) {
-            auto& buf = format_buf_;
-            buf.clear();
-            auto now = std::chrono::steady_clock::now().time_since_epoch();
-            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
-            fmt::format_to(std::back_inserter(buf), "{}.{} ", ns / 1'000'000'000, ns % 1'000'000'000);
-            constexpr const char levels[] = "TDIWEC";
-            fmt::format_to(std::back_inserter(buf), "{} ", levels[static_cast<int>(L)]);
-            fmt::format_to(std::back_inserter(buf), fmt, std::forward<Args>(args)...);
-            buf.push_back('\n');
-            if (queue_) {
-                if (!batch_.try_add(buf.data(), buf.size())) {
-                    flush_batch();
-                    batch_.try_add(buf.data(), buf.size());
-                }
-            } else {
-                sink_.write({buf.data(), buf.size()});
+    bool can_push() const {
+        size_t current_tail = tail_.value.load(std::memory_order_relaxed);
+        return current_tail % CHUNK_ENTRIES != 0 || current_tail == 0 || !pool_.exhausted();
+    }
+
+    // Producer side, on an empty queue: the records about to be pushed follow
+    // everything below `sequence` in ring `ring`, and must not be merged ahead of it.
+    void set_barrier(size_t ring, size_t sequence) {
+        barrier_ring_.store(ring, std::memory_order_relaxed);
+        barrier_sequence_.store(sequence, std::memory_order_relaxed);
+    }
+    // Consumer side: only meaningful once a record has been seen (through
+    // peek_timestamp or try_dequeue), which makes its barrier visible.
+    size_t barrier_ring() const { return barrier_ring_.load(std::memory_order_relaxed); }
+    size_t barrier_sequence() const { return barrier_sequence_.load(std::memory_order_relaxed); }
+
+    bool try_dequeue(char* data, size_t& len) {
+        const char* slot = front();
+        if (!slot) return false;
+        uint16_t slot_len;
+        memcpy(&slot_len, slot + ENTRY_SIZE - sizeof(slot_len), sizeof(slot_len));
+        len = slot_len;
+        memcpy(data, slot, len);
+        head_.value.store(head_.value.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool peek_timestamp(uint64_t& timestamp) {
+        const char* slot = front();
+        if (!slot) return false;
+        memcpy(&timestamp, slot + ENTRY_SIZE - LockFreeRingBuffer::TRAILER_SIZE, sizeof(timestamp));
+        return true;
+    }
+
+    size_t head_sequence() const { return head_.value.load(std::memory_order_acquire); }
+    size_t tail_sequence() const { return tail_.value.load(std::memory_order_acquire); }
+    bool empty() const { return head_sequence() == tail_sequence(); }
+};
+
+namespace detail {
+
+// Non-template formatting core, compiled into libzerolog.a so that call
+// sites only build fmt::format_args.
+
+// "<seconds>.<nanoseconds> <level> "
+void format_prefix(fmt::memory_buffer& buf, LogLevel level, int64_t ns);
+
+// Prefix, message and newline appended to `buf`.
+void format_record(fmt::memory_buffer& buf, LogLevel level, int64_t ns,
+                   fmt::string_view fmt, fmt::format_args args);
+
+// The same into `out`. False if it does not fit in `room`.
+bool format_line(char* out, size_t room, size_t& used, LogLevel level, int64_t ns,
+                 fmt::string_view fmt, fmt::format_args args);
+
+// Stands in for a record whose formatting threw: the prefix, the error and
+// the unformatted format string.
+void format_error_record(fmt::memory_buffer& buf, LogLevel level, int64_t ns,
+                         fmt::string_view fmt, const char* what);
+
+// Leads a deferred record, followed by a copy of the format string (the
+// caller's may be a runtime string gone by the time the consumer formats)
+// and the encoded arguments. Formatted records start with a digit, never
+// with a zero byte.
+struct DeferredHeader {
+    uint8_t tag = 0;
+    uint8_t level;
+    uint16_t fmt_size;
+    int64_t ns;
+    DeferredFormat format;
+    DeferredDiscard discard;  // set when the record owns pooled strings
+};
+
+// Descriptor shared by CONCURRENT_SYNC line buffers; a buffer may outlive
+// its logger until its thread exits, so it keeps the descriptor open.
+struct SharedFd {
+    const int fd;
+    explicit SharedFd(int descriptor) : fd(descriptor) {}
+    SharedFd(const SharedFd&) = delete;
+    SharedFd& operator=(const SharedFd&) = delete;
+    ~SharedFd() { ::close(fd); }
+};
+
+// A thread's pending whole lines. Each emit() is a single write(2), which
+// O_APPEND keeps from interleaving with other threads' writes; up to
+// PIPE_BUF bytes this also holds for pipes. Every buffer is listed so that
+// Logger::flush() can emit other threads' lines too; the owning thread
+// takes the buffer's lock for each append, which is uncontended except
+// during such a flush.
+struct LineBuffer {
+    std::mutex mtx;
+    std::shared_ptr<SharedFd> target;
+    size_t used = 0;
+    char data[PIPE_BUF];
+
+    LineBuffer() {
+        std::lock_guard<std::mutex> lock(registry_mtx());
+        registry().push_back(this);
+    }
+
+    ~LineBuffer() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            emit();
+        }
+        std::lock_guard<std::mutex> lock(registry_mtx());
+        auto& buffers = registry();
+        buffers.erase(std::find(buffers.begin(), buffers.end(), this));
+    }
+
+    LineBuffer(const LineBuffer&) = delete;
+    LineBuffer& operator=(const LineBuffer&) = delete;
+
+    // Emits the pending lines of every thread's buffer that writes to `fd`.
+    static void emit_all(const std::shared_ptr<SharedFd>& fd) {
+        std::lock_guard<std::mutex> registry_lock(registry_mtx());
+        for (LineBuffer* buffer : registry()) {
+            std::lock_guard<std::mutex> lock(buffer->mtx);
+            if (buffer->target == fd) {
+                buffer->emit();
             }
         }
     }
 
-    void flush() {
-        if (batch_.size() > 0) {
-            flush_batch();
+    void add(const std::shared_ptr<SharedFd>& fd, const char* line, size_t len) {
+        std::lock_guard<std::mutex> lock(mtx);
+        append(fd, line, len);
+    }
+
+private:
+    static std::mutex& registry_mtx() {
+        static std::mutex mtx;
+        return mtx;
+    }
+    static std::vector<LineBuffer*>& registry() {
+        static std::vector<LineBuffer*> buffers;
+        return buffers;
+    }
+
+    void emit() {
+        if (used > 0 && target) {
+            write_whole(data, used);
         }
-        if (worker_) {
-            while (!queue_->empty()) {
-                std::this_thread::yield();
+        used = 0;
+    }
+
+    void write_whole(const char* bytes, size_t len) {
+        while (len > 0) {
+            ssize_t n = ::write(target->fd, bytes, len);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return;
             }
+            bytes += n;
+            len -= static_cast<size_t>(n);
         }
-        sink_.flush();
     }
 
-    template<typename... Args> void trace(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::TRACE>(fmt, std::forward<Args>(args)...);}
-    template<typename... Args> void debug(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::DEBUG>(fmt, std::forward<Args>(args)...);}
-    template<typename... Args> void info(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::INFO>(fmt, std::forward<Args>(args)...);}
-    template<typename... Args> void warn(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::WARN>(fmt, std::forward<Args>(args)...);}
-    template<typename... Args> void error(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::ERROR>(fmt, std::forward<Args>(args)...);}
-    template<typename... Args> void critical(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::CRITICAL>(fmt, std::forward<Args>(args)...);}
+    void append(const std::shared_ptr<SharedFd>& fd, const char* line, size_t len) {
+        if (target != fd) {
+            emit();
+            target = fd;
+        }
+        if (len > sizeof(data) - used) {
+            emit();
+            if (len > sizeof(data)) {
+                write_whole(line, len);
+                return;
+            }
+        }
+        memcpy(data + used, line, len);
+        used += len;
+    }
 };
 
-struct NullSink {
-    void write(std::string_view) {}
-    void flush() {}
-};
+// Everything past a log statement's level check. A non-member so that call
+// sites make a plain direct call into a cold section, and so that it also
+// serves as the LogRef entry point.
+template<typename Logger>
+[[gnu::cold]] [[gnu::noinline]] void vlog(void* logger, LogLevel level, fmt::string_view fmt,
+                                          fmt::format_args args) {
+    static_cast<Logger*>(logger)->vlog(level, fmt, args);
+}
 
-struct StdoutSink {
-    void write(std::string_view sv) { 
-        fwrite(sv.data(), 1, sv.size(), stdout); 
+} // namespace detail
+
+template<typename Sink, LogLevel MinLevel = LogLevel::TRACE, typename WaitStrategy = BlockingWait,
+         typename Producers = MultiProducer>
+class Logger {
+private:
+    using Ring = BasicRingBuffer<Producers>;
+    static constexpr bool SINGLE_PRODUCER = std::is_same_v<Producers, SingleProducer>;
+    static constexpr size_t ENTRY_SIZE = 256;
+    static constexpr size_t MAX_RECORD = ENTRY_SIZE - LockFreeRingBuffer::TRAILER_SIZE;
+    Sink sink_;
+    std::unique_ptr<RingFile> ring_file_;  // outlives the ring mapped from it
+    std::vector<std::unique_ptr<ResizableRing<Ring>>> queues_;
+    std::vector<int> queue_of_cpu_;
+    bool rseq_commit_ = false;
+    struct MergeHead {
+        uint64_t timestamp;
+        size_t queue;
+        static bool later(const MergeHead& a, const MergeHead& b) { return a.timestamp > b.timestamp; }
+    };
+    // Resizing bookkeeping, one entry per ring; consumer side only.
+    struct RingLoad {
+        size_t base_capacity;
+        std::vector<int> cpus;
+        uint64_t window_start;
+        size_t high_water = 0;
+        unsigned hot_windows = 0;
+        uint64_t idle_since = 0;
+    };
+    std::vector<RingLoad> ring_load_;
+    size_t max_ring_capacity_ = 0;
+    uint64_t shrink_after_ = 0;
+    static constexpr uint64_t RESIZE_WINDOW_NS = 10'000'000;
+    static constexpr unsigned GROW_WINDOWS = 3;
+    std::vector<MergeHead> merge_heap_;
+    std::vector<uint8_t> in_merge_;
+    uint64_t reorder_window_ = 0;
+    uint64_t held_until_ = 0;
+    OverflowPolicy overflow_ = OverflowPolicy::BLOCK;
+    std::atomic<uint64_t> dropped_{0};
+    // Elastic mode: one chunk queue per producer thread, registered on first
+    // overflow; the consumer merges them with the rings via elastic_sources_.
+    std::unique_ptr<ChunkPool> chunk_pool_;
+    std::mutex elastic_mtx_;
+    std::vector<std::pair<std::thread::id, std::unique_ptr<ElasticQueue>>> elastic_queues_;
+    std::atomic<size_t> elastic_count_{0};
+    std::vector<ElasticQueue*> elastic_sources_;
+    static inline std::atomic<uint64_t> next_logger_id_{1};
+    const uint64_t logger_id_ = next_logger_id_.fetch_add(1, std::memory_order_relaxed);
+    struct ElasticHandle {
+        uint64_t logger_id = 0;
+        ElasticQueue* queue = nullptr;
+    };
+    // SPILL: while active, producers append to the file instead of queueing.
+    // The worker replays in rounds. A round covers the records appended
+    // before it began (up to spill_round_end_); the barrier holds each
+    // source's tail at that moment, and the round starts only once every
+    // source has drained past it. A thread's queued records therefore reach
+    // the sink before any record it spilled later, even when it was still
+    // queueing after another thread had started spilling.
+    std::unique_ptr<SpillFile> spill_;
+    std::mutex spill_mtx_;
+    std::atomic<bool> spill_active_{false};
+    std::vector<size_t> spill_barrier_;
+    std::atomic<uint64_t> spill_appended_{0};
+    uint64_t spill_replayed_ = 0;
+    uint64_t spill_round_end_ = 0;
+    uint64_t spill_swap_sequence_ = 0;
+    static constexpr size_t SPILL_BUFFER = 8192;
+    std::unique_ptr<std::thread> worker_;
+    WaitStrategy data_wait_;
+    WaitStrategy space_wait_;
+    std::atomic<bool> running_{true};
+    std::atomic<bool> swap_pending_{false};
+    std::mutex swap_mtx_;
+    std::condition_variable swap_cv_;
+    std::unique_ptr<Sink> pending_sink_;
+    std::vector<size_t> swap_sequences_;
+    std::atomic<uint64_t> flush_requests_{0};
+    std::atomic<uint64_t> flushes_done_{0};
+    int event_fd_ = -1;
+    std::atomic<bool> drain_armed_{true};
+    std::atomic<std::thread::id> drain_owner_{};
+    static constexpr size_t DRAIN_BURST = 64;
+    static constexpr size_t MIN_RING_CAPACITY = 256;
+    thread_local static inline fmt::memory_buffer format_buf_;
+    thread_local static inline ThreadLocalBatch batch_;
+    thread_local static inline ElasticHandle elastic_handle_;
+    // CONCURRENT_SYNC: a descriptor for the sink's file in append mode.
+    std::shared_ptr<detail::SharedFd> line_fd_;
+    thread_local static inline detail::LineBuffer line_buffer_;
+    // SYNC mode with a sink that provides a buffer: records are formatted
+    // straight into it.
+    bool format_in_sink_ = false;
+    static constexpr size_t SINK_RESERVE = 256;
+    // Sinks with write_batch but no buffer of their own: the consumer stages up to DRAIN_BURST dequeued
+    // records and hands them over in one call.
+    std::unique_ptr<char[]> staged_;
+    std::vector<std::string_view> staged_views_;
+    // Deferred formatting: consumer-side scratch for decoded records.
+    bool deferred_ = false;
+    fmt::memory_buffer deferred_buf_;
+    // Sinks with tick(): next time the consumer calls it.
+    static constexpr uint64_t TICK_INTERVAL_NS = 10'000'000;
+    uint64_t next_tick_ = 0;
+    
+    // Consumer side: picks up elastic queues registered since the last call.
+    void refresh_sources() {
+        if (elastic_count_.load(std::memory_order_acquire) == elastic_sources_.size()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(elastic_mtx_);
+        for (size_t i = elastic_sources_.size(); i < elastic_queues_.size(); ++i) {
+            elastic_sources_.push_back(elastic_queues_[i].second.get());
+        }
     }
-    void flush() { fflush(stdout); }
-};
+
+    // Sources are the rings followed by the elastic queues.
+    size_t source_count() const { return queues_.size() + elastic_sources_.size(); }
+
+    size_t source_head(size_t source) const {
+        return source < queues_.size() ? queues_[source]->head_sequence()
+                                       : elastic_sources_[source - queues_.size()]->head_sequence();
+    }
+
+    size_t source_tail(size_t source) const {
+        return source < queues_.size() ? queues_[source]->tail_sequence()
+                                       : elastic_sources_[source - queues_.size()]->tail_sequence();
+    }
+
+    bool peek_source(size_t source, uint64_t& timestamp) {
+        return source < queues_.size() ? queues_[source]->peek_timestamp(timestamp)
+                                       : elastic_sources_[source - queues_.size()]->peek_timestamp(timestamp);
+    }
+
+    // Runs on the worker: once every record enqueued before the swap request
+    // has been written, flush the old sink and switch to the new one.
+    void maybe_swap_sink() {
+        if (!swap_pending_.load(std::memory_order_acquire)) {
+            return;
+        }
+        refresh_sources();
+        for (size_t i = 0; i < swap_sequences_.size(); ++i) {
+            if (source_head(i) < swap_sequences_[i]) return;
+        }
+        if (spill_replayed_ < spill_swap_sequence_) {
+            return;
+        }
+        write_staged();
+        std::unique_ptr<Sink> old;
+        {
+            std::lock_guard<std::mutex> lock(swap_mtx_);
+            sink_.flush();
+            std::swap(sink_, *pending_sink_);
+            old = std::move(pending_sink_);
+            swap_pending_.store(false, std::memory_order_release);
+        }
+        swap_cv_.notify_all();
+    }
+
+    bool queues_empty() const {
+        for (const auto& queue : queues_) {
+            if (!queue->empty()) return false;
+        }
+        if (elastic_count_.load(std::memory_order_acquire) != elastic_sources_.size()) {
+            return false;
+        }
+        for (const ElasticQueue* queue : elastic_sources_) {
+            if (!queue->empty()) return false;
+        }
+        return !spill_active_.load(std::memory_order_acquire);
+    }
+
+    uint64_t now_ns() const {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // While a sink swap is pending, sources already drained to the swap point
+    // are held back so their newer records reach the new sink. An elastic
+    // queue also waits for the ring records its producer wrote before it;
+    // its barrier is only current after a successful peek_source().
+    bool merge_eligible(size_t source) const {
+        if (source >= queues_.size()) {
+            const ElasticQueue& queue = *elastic_sources_[source - queues_.size()];
+            if (queues_[queue.barrier_ring()]->head_sequence() < queue.barrier_sequence()) {
+                return false;
+            }
+        }
+        if (!swap_pending_.load(std::memory_order_acquire)) {
+            return true;
+        }
+        return source < swap_sequences_.size() && source_head(source) < swap_sequences_[source];
+    }
+
+    void push_merge(uint64_t timestamp, size_t source) {
+        merge_heap_.push_back({timestamp, source});
+        std::push_heap(merge_heap_.begin(), merge_heap_.end(), MergeHead::later);
+        in_merge_[source] = 1;
+    }
+
+    void pop_merge() {
+        in_merge_[merge_heap_.front().queue] = 0;
+        std::pop_heap(merge_heap_.begin(), merge_heap_.end(), MergeHead::later);
+        merge_heap_.pop_back();
+    }
+
+    // Adds the heads of sources that were empty (or held back) last time.
+    void refresh_merge() {
+        if (in_merge_.size() != source_count()) {
+            in_merge_.assign(source_count(), 0);
+            merge_heap_.clear();
+        }
+        for (size_t i = 0; i < in_merge_.size(); ++i) {
+            uint64_t ts;
+            if (!in_merge_[i] && peek_source(i, ts) && merge_eligible(i)) {
+                push_merge(ts, i);
+            }
+        }
+    }
+
+    bool under_pressure() const {
+        for (const auto& queue : queues_) {
+            if (queue->size() * 2 >= queue->capacity()) return true;
+        }
+        return false;
+    }
+
+    // Where the next record is dequeued to: straight into the sink's buffer
+    // when it provides one (committed by write_record, so each byte is copied
+    // once), the next staging slot when it takes batches, else `entry`.
+    char* record_slot(char* entry) {
+        if constexpr (provides_buffer_v<Sink>) {
+            return sink_.reserve(ENTRY_SIZE).first;
+        } else if constexpr (has_write_batch_v<Sink>) {
+            return staged_.get() + staged_views_.size() * ENTRY_SIZE;
+        } else {
+            return entry;
+        }
+    }
+
+    void write_record(const char* record, size_t len) {
+        if (deferred_ && record[0] == '\0') {
+            write_deferred(record, len);
+            return;
+        }
+        if constexpr (provides_buffer_v<Sink>) {
+            sink_.commit(len);
+        } else if constexpr (has_write_batch_v<Sink>) {
+            staged_views_.emplace_back(record, len);
+            if (staged_views_.size() == DRAIN_BURST) {
+                write_staged();
+            }
+        } else {
+            sink_.write({record, len});
+        }
+    }
+
+    // Formats on the consumer. This runs on the worker thread, so an error
+    // from fmt or from a user formatter becomes a placeholder line instead
+    // of escaping worker_loop.
+    void write_deferred(const char* record, size_t len) {
+        struct Line {
+            Logger* logger;
+            LogLevel level;
+            int64_t ns;
+            fmt::string_view fmt;
+        };
+        alignas(8) char copy[ENTRY_SIZE];
+        if constexpr (provides_buffer_v<Sink>) {
+            // Dequeued into the sink's reserved space, where the line goes.
+            memcpy(copy, record, len);
+            record = copy;
+        }
+        detail::DeferredHeader header;
+        memcpy(&header, record, sizeof(header));
+        const char* format = record + sizeof(header);
+        Line line{this, static_cast<LogLevel>(header.level), header.ns, {format, header.fmt_size}};
+        try {
+            header.format(format + header.fmt_size, [](void* context, fmt::format_args args) {
+                Line& line = *static_cast<Line*>(context);
+                line.logger->write_line(line.level, line.ns, line.fmt, args);
+            }, &line);
+        } catch (const std::exception& e) {
+            write_format_error(line.level, line.ns, line.fmt, e.what());
+        } catch (...) {
+            write_format_error(line.level, line.ns, line.fmt, "unknown exception");
+        }
+    }
+
+    // Consumer side: a deferred record's line, straight into the sink's
+    // buffer when it has one.
+    void write_line(LogLevel level, int64_t ns, fmt::string_view fmt, fmt::format_args args) {
+        if constexpr (provides_buffer_v<Sink>) {
+            auto [out, room] = sink_.reserve(SINK_RESERVE);
+            size_t used;
+            if (detail::format_line(out, room, used, level, ns, fmt, args)) {
+                sink_.commit(used);
+                return;
+            }
+        }
+        auto& buf = deferred_buf_;
+        buf.clear();
+        detail::format_record(buf, level, ns, fmt, args);
+        write_staged();
+        sink_.write({buf.data(), buf.size()});
+    }
+
+    void write_format_error(LogLevel level, int64_t ns, fmt::string_view fmt, const char* what) {
+        auto& buf = deferred_buf_;
+        buf.clear();
+        detail::format_error_record(buf, level, ns, fmt, what);
+        write_staged();
+        sink_.write({buf.data(), buf.size()});
+    }
+
+    void write_staged() {
+        if constexpr (has_write_batch_v<Sink> && !provides_buffer_v<Sink>) {
+            if (!staged_views_.empty()) {
+                sink_.write_batch(staged_views_.data(), staged_views_.size());
+                staged_views_.clear();
+            }
+        }
+    }
+
+    void maybe_tick() {
+        if constexpr (needs_periodic_tick_v<Sink>) {
+            const uint64_t now = now_ns();
+            if (now >= next_tick_) {
+                write_staged();
+                sink_.tick();
+                next_tick_ = now + TICK_INTERVAL_NS;
+            }
+        }
+    }
+
+    bool tick_due() const {
+        if constexpr (needs_periodic_tick_v<Sink>) {
+            return now_ns() >= next_tick_;
+        } else {
+            return false;
+        }
+    }
+
+    bool write_from(size_t source, char* entry) {
+        char* record = record_slot(entry);
+        size_t len;
+        bool dequeued = source < queues_.size()
+            ? queues_[source]->try_dequeue(record, len)
+            : elastic_sources_[source - queues_.size()]->try_dequeue(record, len);
+        if (!dequeued) {
+            return false;
+        }
+        write_record(record, len);
+        maybe_swap_sink();
+        return true;
+    }
+
+    // Consumer side: replays spilled records a round at a time (see
+    // spill_barrier_), and ends the spill when caught up.
+    size_t replay_spill(char* entry, size_t max_records) {
+        if (!spill_active_.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        if (spill_replayed_ >= spill_round_end_) {
+            // Acquire first: every record queued before one of these was
+            // spilled is then below the tails read next.
+            spill_round_end_ = spill_appended_.load(std::memory_order_acquire);
+            refresh_sources();
+            spill_barrier_.clear();
+            for (size_t i = 0; i < source_count(); ++i) {
+                spill_barrier_.push_back(source_tail(i));
+            }
+        }
+        for (size_t i = 0; i < spill_barrier_.size(); ++i) {
+            if (source_head(i) < spill_barrier_[i]) return 0;
+        }
+        size_t written = 0;
+        size_t len;
+        uint64_t timestamp;
+        while (written < max_records && spill_replayed_ < spill_round_end_) {
+            if (swap_pending_.load(std::memory_order_acquire) && spill_replayed_ >= spill_swap_sequence_) {
+                return written;
+            }
+            char* record = record_slot(entry);
+            if (!spill_->read_next(record, len, timestamp)) {
+                break;
+            }
+            ++spill_replayed_;
+            ++written;
+            write_record(record, len);
+            maybe_swap_sink();
+        }
+        if (written < max_records && spill_->caught_up()) {
+            std::lock_guard<std::mutex> lock(spill_mtx_);
+            if (spill_->caught_up()) {
+                spill_->reset();
+                spill_active_.store(false, std::memory_order_release);
+            }
+            space_wait_.signal();
+        }
+        return written;
+    }
+
+    size_t write_burst(char* entry, size_t max_records, bool hold) {
+        refresh_sources();
+        size_t written = write_sources(entry, max_records, hold);
+        if (spill_ && written < max_records) {
+            written += replay_spill(entry, max_records - written);
+        }
+        write_staged();
+        if (ring_file_ && written > 0) {
+            sink_.flush();
+            queues_[0]->release();
+        }
+        return written;
+    }
+
+    // Consumer side: writes up to max_records, k-way merged by timestamp
+    // across sources with a heap over their heads. With a reorder window and
+    // `hold` set, a record waits until it is reorder_window_ old so that late
+    // records from other sources can still be merged ahead of it; a ring
+    // past half full releases everything.
+    size_t write_sources(char* entry, size_t max_records, bool hold) {
+        size_t written = 0;
+        if (source_count() == 1) {
+            while (written < max_records && write_from(0, entry)) {
+                ++written;
+            }
+            return written;
+        }
+        held_until_ = 0;
+        uint64_t watermark = UINT64_MAX;
+        if (hold && reorder_window_ > 0 && !under_pressure()) {
+            const uint64_t now = now_ns();
+            watermark = now > reorder_window_ ? now - reorder_window_ : 0;
+        }
+        while (written < max_records) {
+            // Sources not in the heap are peeked again before every write: a
+            // thread that moved to another ring published its earlier record
+            // before the top one, so the top's peek makes it visible here.
+            refresh_merge();
+            if (merge_heap_.empty()) {
+                break;
+            }
+            const MergeHead top = merge_heap_.front();
+            if (!merge_eligible(top.queue)) {
+                pop_merge();
+                continue;
+            }
+            if (top.timestamp > watermark) {
+                held_until_ = top.timestamp + reorder_window_;
+                break;
+            }
+            pop_merge();
+            write_from(top.queue, entry);
+            ++written;
+        }
+        return written;
+    }
+
+    // Consumer side: tracks each ring's high-water mark per RESIZE_WINDOW_NS.
+    // A ring whose mark reaches 3/4 of capacity for GROW_WINDOWS windows in a
+    // row doubles (up to max_ring_capacity_); one whose mark has stayed under
+    // 1/8 for shrink_after_ goes back to its original capacity.
+    void maybe_resize() {
+        if (max_ring_capacity_ == 0) {
+            return;
+        }
+        const uint64_t now = now_ns();
+        for (size_t i = 0; i < queues_.size(); ++i) {
+            ResizableRing<Ring>& ring = *queues_[i];
+            RingLoad& load = ring_load_[i];
+            if (ring.resizing()) {
+                continue;
+            }
+            load.high_water = std::max(load.high_water, ring.size());
+            if (now - load.window_start < RESIZE_WINDOW_NS) {
+                continue;
+            }
+            size_t capacity = ring.capacity();
+            if (load.high_water * 4 >= capacity * 3) {
+                load.idle_since = 0;
+                if (++load.hot_windows >= GROW_WINDOWS && capacity < max_ring_capacity_) {
+                    resize_ring(i, std::min(capacity * 2, max_ring_capacity_));
+                }
+            } else if (load.high_water * 8 <= capacity) {
+                load.hot_windows = 0;
+                if (load.idle_since == 0) {
+                    load.idle_since = load.window_start;
+                }
+                if (capacity > load.base_capacity && now - load.idle_since >= shrink_after_) {
+                    resize_ring(i, load.base_capacity);
+                }
+            } else {
+                load.hot_windows = 0;
+                load.idle_since = 0;
+            }
+            load.window_start = now;
+            load.high_water = 0;
+        }
+    }
+
+    void resize_ring(size_t index, size_t capacity) {
+        RingLoad& load = ring_load_[index];
+        load.hot_windows = 0;
+        load.idle_since = 0;
+        try {
+            queues_[index]->resize(load.cpus.empty()
+                ? std::make_unique<Ring>(ENTRY_SIZE, capacity)
+                : allocate_queue_on(load.cpus, capacity));
+        } catch (const std::bad_alloc&) {
+            // Keep the current ring; sustained pressure retries later.
+        }
+    }
+
+    // Lets a sleeping worker wake up to shrink an idle ring.
+    bool shrink_due() const {
+        if (max_ring_capacity_ == 0) {
+            return false;
+        }
+        const uint64_t now = now_ns();
+        for (size_t i = 0; i < ring_load_.size(); ++i) {
+            const RingLoad& load = ring_load_[i];
+            size_t capacity = queues_[i]->capacity();
+            uint64_t idle_since = load.idle_since != 0 ? load.idle_since
+                                : load.high_water * 8 <= capacity ? load.window_start : 0;
+            if (capacity > load.base_capacity && idle_since != 0 && now - idle_since >= shrink_after_) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool flush_requested() const {
+        return flushes_done_.load(std::memory_order_relaxed) !=
+               flush_requests_.load(std::memory_order_relaxed);
+    }
+
+    bool worker_has_work() const {
+        if (!running_.load(std::memory_order_relaxed) ||
+            swap_pending_.load(std::memory_order_relaxed) || flush_requested() || shrink_due() || tick_due()) {
+            return true;
+        }
+        return held_until_ != 0 ? now_ns() >= held_until_ : !queues_empty();
+    }
+
+    void worker_loop() {
+        char entry[ENTRY_SIZE];
+        while (running_.load(std::memory_order_acquire)) {
+            maybe_swap_sink();
+            maybe_resize();
+            maybe_tick();
+            bool hold = !swap_pending_.load(std::memory_order_relaxed) && !flush_requested();
+            size_t drained = write_burst(entry, DRAIN_BURST, hold);
+            if (drained > 0) {
+                space_wait_.signal();
+            } else if (flush_requested()) {
+                serve_flush_request();
+            } else {
+                data_wait_.wait([this] { return worker_has_work(); });
+            }
+        }
+        while (write_burst(entry, DRAIN_BURST, false) > 0) {
+        }
+        maybe_swap_sink();
+        flushes_done_.store(flush_requests_.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Flush the sink on the worker once every record enqueued before the
+    // request has been written; the sink is never touched from two threads.
+    void serve_flush_request() {
+        uint64_t requested = flush_requests_.load(std::memory_order_acquire);
+        if (!queues_empty()) return;
+        sink_.flush();
+        flushes_done_.store(requested, std::memory_order_release);
+    }
+
+    // Producers share the ring of their NUMA node (or of their CPU when rseq
+    // is unavailable); sched_getcpu is a vDSO call, paid once per batch.
+    size_t producer_ring() const {
+        if (queue_of_cpu_.empty()) {
+            return 0;
+        }
+        int cpu = detail::current_cpu();
+        return cpu >= 0 && static_cast<size_t>(cpu) < queue_of_cpu_.size() ? queue_of_cpu_[cpu] : 0;
+    }
+
+    // `hold` applies the reorder window; the drains the library does itself
+    // (flush, swap_sink, a drain owner waiting for space) write everything.
+    // Only drain() moves drain_owner_ to the calling thread.
+    size_t drain_queues(size_t max_records, std::chrono::nanoseconds max_time, bool hold) {
+        if (event_fd_ >= 0) {
+            uint64_t counter;
+            [[maybe_unused]] ssize_t n = ::read(event_fd_, &counter, sizeof(counter));
+        }
+        const bool timed = max_time != std::chrono::nanoseconds::max();
+        const auto deadline = timed ? std::chrono::steady_clock::now() + max_time
+                                    : std::chrono::steady_clock::time_point::max();
+        maybe_resize();
+        maybe_tick();
+        char entry[ENTRY_SIZE];
+        size_t drained = 0;
+        while (drained < max_records) {
+            size_t written = write_burst(entry, std::min(max_records - drained, DRAIN_BURST), hold);
+            drained += written;
+            if (written == 0 || (timed && std::chrono::steady_clock::now() >= deadline)) {
+                break;
+            }
+        }
+        if (drained > 0) {
+            space_wait_.signal();
+        }
+        if (event_fd_ >= 0) {
+            drain_armed_.store(true, std::memory_order_release);
+            if (held_until_ == 0 && !queues_empty()) {
+                signal_drain();
+            }
+        }
+        return drained;
+    }
+
+    size_t drain_all() { return drain_queues(SIZE_MAX, std::chrono::nanoseconds::max(), false); }
+
+    template<typename Ready>
+    void wait_for_space(Ready ready) {
+        if (!worker_ && drain_owner_.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+            drain_all();
+            return;
+        }
+        space_wait_.wait(ready);
+    }
+
+    static constexpr size_t PUBLISHED = SIZE_MAX;
+
+    // One attempt at a slot image (payload and trailer); returns PUBLISHED or
+    // the index of the ring that was full. PER_CPU commits into the ring of
+    // whichever CPU we are on; preemption or migration inside the rseq
+    // critical section just restarts the attempt.
+    size_t try_publish(const char* image, size_t ring) {
+#if ZEROLOG_HAS_RSEQ
+        while (rseq_commit_) {
+            int cpu = detail::rseq_cpu();
+            if (cpu < 0 || static_cast<size_t>(cpu) >= queues_.size()) {
+                std::this_thread::yield();
+                continue;
+            }
+            switch (queues_[cpu]->try_enqueue_on_cpu(cpu, image)) {
+            case Ring::CpuEnqueue::OK:
+                return PUBLISHED;
+            case Ring::CpuEnqueue::FULL:
+                return static_cast<size_t>(cpu);
+            case Ring::CpuEnqueue::RETRY:
+                break;
+            }
+        }
+#endif
+        uint16_t len;
+        uint64_t timestamp;
+        memcpy(&len, image + ENTRY_SIZE - sizeof(len), sizeof(len));
+        memcpy(&timestamp, image + ENTRY_SIZE - LockFreeRingBuffer::TRAILER_SIZE, sizeof(timestamp));
+        return queues_[ring]->try_enqueue(image, len, timestamp) ? PUBLISHED : ring;
+    }
+
+    // Elastic mode: the calling thread's chunk queue, created on first use.
+    ElasticQueue* elastic_queue(bool create) {
+        ElasticHandle& handle = elastic_handle_;
+        if (handle.logger_id == logger_id_ && (handle.queue || !create)) {
+            return handle.queue;
+        }
+        handle = {logger_id_, nullptr};
+        if (!create) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(elastic_mtx_);
+        const std::thread::id self = std::this_thread::get_id();
+        for (auto& [owner, queue] : elastic_queues_) {
+            if (owner == self) return handle.queue = queue.get();
+        }
+        ChunkPool::Chunk* first = chunk_pool_->acquire();
+        if (!first) {
+            return nullptr;
+        }
+        elastic_queues_.emplace_back(self, std::make_unique<ElasticQueue>(*chunk_pool_, first));
+        elastic_count_.store(elastic_queues_.size(), std::memory_order_release);
+        return handle.queue = elastic_queues_.back().second.get();
+    }
+
+    // Producer side: a full ring either blocks, drops, or in elastic mode
+    // diverts the thread's records into its chunk queue until that drains,
+    // so per-thread order is kept. Returns false when the record has to be
+    // spilled instead.
+    bool publish(const char* image, size_t ring, OverflowPolicy policy) {
+        if (policy == OverflowPolicy::SPILL && spill_active_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        ElasticQueue* spill = chunk_pool_ ? elastic_queue(false) : nullptr;
+        for (;;) {
+            size_t full = PUBLISHED;
+            if (spill && !spill->empty()) {
+                if (spill->try_push(image)) return true;
+            } else {
+                full = try_publish(image, ring);
+                if (full == PUBLISHED) return true;
+                if (chunk_pool_ && (spill = elastic_queue(true)) != nullptr) {
+                    if (spill->empty()) {
+                        spill->set_barrier(full, queues_[full]->tail_sequence());
+                    }
+                    if (spill->try_push(image)) return true;
+                }
+            }
+            if (policy == OverflowPolicy::DROP) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                discard_record(image);
+                return true;
+            }
+            if (policy == OverflowPolicy::SPILL) {
+                return false;
+            }
+            data_wait_.signal();
+            if (full == PUBLISHED) {
+                wait_for_space([spill] { return spill->can_push() || spill->empty(); });
+            } else {
+                wait_for_space([&queue = *queues_[full]] { return !queue.full(); });
+            }
+        }
+    }
+
+    // A dropped deferred record may own pooled strings.
+    void discard_record(const char* image) {
+        if (deferred_ && image[0] == '\0') {
+            detail::DeferredHeader header;
+            memcpy(&header, image, sizeof(header));
+            if (header.discard) {
+                header.discard(image + sizeof(header) + header.fmt_size);
+            }
+        }
+    }
+
+    void enqueue_record(const char* data, size_t len, uint64_t timestamp) {
+        alignas(8) char image[ENTRY_SIZE];
+        memcpy(image, data, len);
+        memcpy(image + ENTRY_SIZE - LockFreeRingBuffer::TRAILER_SIZE, &timestamp, sizeof(timestamp));
+        uint16_t len16 = static_cast<uint16_t>(len);
+        memcpy(image + ENTRY_SIZE - sizeof(len16), &len16, sizeof(len16));
+        size_t ring = rseq_commit_ ? 0 : producer_ring();
+        if (!publish(image, ring, overflow_)) {
+            spill_or_block(1, [&image](size_t) -> const char* { return image; }, ring);
+        }
+    }
+
+    // Appends slot images to the spill file, one write per buffer-full.
+    // Returns how many made it; an I/O error stops early.
+    template<typename ImageAt>
+    size_t spill(size_t count, ImageAt image_at) {
+        char buffer[SPILL_BUFFER];
+        size_t used = 0;
+        size_t buffered = 0;
+        size_t spilled = 0;
+        std::lock_guard<std::mutex> lock(spill_mtx_);
+        spill_active_.store(true, std::memory_order_release);
+        for (size_t i = 0; i < count; ++i) {
+            const char* image = image_at(i);
+            uint16_t len;
+            uint64_t timestamp;
+            memcpy(&len, image + ENTRY_SIZE - sizeof(len), sizeof(len));
+            memcpy(&timestamp, image + ENTRY_SIZE - LockFreeRingBuffer::TRAILER_SIZE, sizeof(timestamp));
+            if (used + SpillFile::HEADER_SIZE + len > sizeof(buffer)) {
+                if (!spill_->append(buffer, used)) break;
+                spilled += buffered;
+                used = buffered = 0;
+            }
+            used += SpillFile::encode(buffer + used, image, len, timestamp);
+            ++buffered;
+        }
+        if (spilled + buffered == count && used > 0 && spill_->append(buffer, used)) {
+            spilled += buffered;
+        }
+        spill_appended_.fetch_add(spilled, std::memory_order_release);
+        return spilled;
+    }
+
+    // Whatever could not be spilled is queued the blocking way, but only
+    // once the spill file has been replayed: the thread's earlier records
+    // may be in it, and must reach the sink first.
+    template<typename ImageAt>
+    void spill_or_block(size_t count, ImageAt image_at, size_t ring) {
+        size_t i = spill(count, image_at);
+        if (i < count) {
+            while (spill_active_.load(std::memory_order_acquire)) {
+                data_wait_.signal();
+                wait_for_space([this] { return !spill_active_.load(std::memory_order_acquire); });
+            }
+        }
+        for (; i < count; ++i) {
+            publish(image_at(i), ring, OverflowPolicy::BLOCK);
+        }
+    }
+
+    // Make event_fd() readable once per drain cycle, not once per record.
+    void signal_drain() {
+        if (drain_armed_.load(std::memory_order_relaxed) &&
+            drain_armed_.exchange(false, std::memory_order_acq_rel)) {
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t n = ::write(event_fd_, &one, sizeof(one));
+        }
+    }
+
+    // MANUAL mode and persistent rings skip the thread's batch: the event
+    // loop is woken per record, and a persistent ring must hold each record
+    // as soon as it is logged, since a batch dies with the process.
+    void submit(const char* record, size_t len, int64_t ns) {
+        if (event_fd_ >= 0) {
+            enqueue_record(record, len, static_cast<uint64_t>(ns));
+            signal_drain();
+        } else if (ring_file_) {
+            enqueue_record(record, len, static_cast<uint64_t>(ns));
+            data_wait_.signal();
+        } else if (!batch_.try_add(record, len, static_cast<uint64_t>(ns))) {
+            flush_batch();
+            batch_.try_add(record, len, static_cast<uint64_t>(ns));
+        }
+    }
+
+    // Reached through detail::vlog, which keeps it out of line.
+    template<typename L>
+    friend void detail::vlog(void* logger, LogLevel level, fmt::string_view fmt, fmt::format_args args);
+
+    void vlog(LogLevel level, fmt::string_view fmt, fmt::format_args args) {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+        if constexpr (provides_buffer_v<Sink>) {
+            if (format_in_sink_) {
+                auto [out, room] = sink_.reserve(SINK_RESERVE);
+                size_t used;
+                if (detail::format_line(out, room, used, level, ns, fmt, args)) {
+                    sink_.commit(used);
+                    return;
+                }
+            }
+        }
+        auto& buf = format_buf_;
+        buf.clear();
+        detail::format_record(buf, level, ns, fmt, args);
+        if (queues_.empty()) {
+            if (line_fd_) {
+                line_buffer_.add(line_fd_, buf.data(), buf.size());
+            } else {
+                sink_.write({buf.data(), buf.size()});
+            }
+            return;
+        }
+        if (buf.size() > MAX_RECORD) {
+            buf.resize(MAX_RECORD);
+            buf[MAX_RECORD - 1] = '\n';
+        }
+        submit(buf.data(), buf.size(), ns);
+    }
+
+    template<LogLevel L, typename... Args>
+    void emit(fmt::format_string<Args...> fmt, Args&&... args) {
+        if constexpr ((has_codec_v<std::decay_t<Args>> && ...)) {
+            if (deferred_) {
+                log_deferred<L, Args...>(fmt, std::forward<Args>(args)...);
+                return;
+            }
+        }
+        detail::vlog<Logger>(this, L, fmt, fmt::make_format_args(args...));
+    }
+
+    // Deferred mode: encodes the arguments behind a DeferredHeader and the
+    // format string, moving long rvalue strings out of line. Formats through
+    // vlog instead if they do not fit in a record, in which case nothing has
+    // been moved.
+    template<LogLevel L, typename... Args>
+    [[gnu::cold]] [[gnu::noinline]] void log_deferred(fmt::format_string<Args...> fmt, Args&&... args) {
+        fmt::string_view format = fmt;
+        const size_t len = sizeof(detail::DeferredHeader) + format.size() +
+                           (size_t{0} + ... + detail::arg_codec_t<Args>::size(args));
+        if (len > MAX_RECORD) {
+            detail::vlog<Logger>(this, L, fmt, fmt::make_format_args(args...));
+            return;
+        }
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+        detail::DeferredHeader header;
+        header.level = static_cast<uint8_t>(L);
+        header.fmt_size = static_cast<uint16_t>(format.size());
+        header.ns = ns;
+        header.format = &detail::format_deferred<detail::arg_codec_t<Args>...>;
+        header.discard = (std::is_same_v<Args, std::string> || ...)
+            ? &detail::discard_deferred<detail::arg_codec_t<Args>...> : nullptr;
+        auto& buf = format_buf_;
+        buf.resize(len);
+        memcpy(buf.data(), &header, sizeof(header));
+        memcpy(buf.data() + sizeof(header), format.data(), format.size());
+        [[maybe_unused]] char* out = buf.data() + sizeof(header) + format.size();
+        ((out = detail::arg_codec_t<Args>::encode(out, std::forward<Args>(args))), ...);
+        submit(buf.data(), len, ns);
+    }
+
+    void flush_batch() {
+        size_t ring = rseq_commit_ ? 0 : producer_ring();
+        for (size_t i = 0; i < batch_.size(); ++i) {
+            if (!publish(batch_[i], ring, overflow_)) {
+                spill_or_block(batch_.size() - i, [i](size_t k) { return batch_[i + k]; }, ring);
+                break;
+            }
+        }
+        batch_.clear();
+        data_wait_.signal();
+    }
+
+    // Allocates from a thread pinned to the given CPUs so that first touch
+    // places the ring on their NUMA node.
+    static std::unique_ptr<Ring> allocate_queue_on(const std::vector<int>& cpus, size_t capacity) {
+        std::unique_ptr<Ring> queue;
+        std::exception_ptr error;
+        std::thread([&] {
+            WorkerOptions placement;
+            placement.cpus = cpus;
+            detail::apply_worker_options(placement);
+            try {
+                queue = std::make_unique<Ring>(ENTRY_SIZE, capacity);
+            } catch (...) {
+                error = std::current_exception();
+            }
+        }).join();
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        return queue;
+    }
+
+    // `cpus` is where replacement rings are allocated when resizing; empty
+    // means on the consumer thread. Rings added once resizing is set up
+    // (the worker's own, with numa_local_queue) are made resizable here.
+    void add_ring(std::unique_ptr<Ring> ring, std::vector<int> cpus = {}) {
+        ring_load_.push_back({ring->capacity(), std::move(cpus), now_ns()});
+        queues_.push_back(std::make_unique<ResizableRing<Ring>>(std::move(ring)));
+        if (max_ring_capacity_ > 0) {
+            queues_.back()->enable_resize();
+        }
+    }
+
+    // A dup shares the sink's open file description, so it is only used when
+    // that is already in append mode or has no offset (pipe, socket, tty).
+    // Otherwise the file is opened again through /proc, leaving the sink's
+    // own descriptor and its flags untouched.
+    void open_line_fd() {
+        if constexpr (exposes_fd_v<Sink>) {
+            const int sink_fd = sink_.fd();
+            const int flags = ::fcntl(sink_fd, F_GETFL);
+            if (flags < 0) {
+                throw std::system_error(errno, std::generic_category(), "zerolog line fd");
+            }
+            int fd;
+            if ((flags & O_APPEND) || (::lseek(sink_fd, 0, SEEK_CUR) < 0 && errno == ESPIPE)) {
+                fd = ::fcntl(sink_fd, F_DUPFD_CLOEXEC, 0);
+            } else {
+                const std::string path = "/proc/self/fd/" + std::to_string(sink_fd);
+                fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+            }
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "zerolog line fd");
+            }
+            line_fd_ = std::make_shared<detail::SharedFd>(fd);
+        } else {
+            throw std::runtime_error("zerolog: CONCURRENT_SYNC needs a sink with fd()");
+        }
+    }
+
+    static LoggerOptions options_for(bool async) {
+        LoggerOptions options;
+        options.mode = async ? LogMode::ASYNC : LogMode::SYNC;
+        return options;
+    }
+
+    static void check_persistent_options(const LoggerOptions& options) {
+        const char* conflict = nullptr;
+        if (options.mode != LogMode::ASYNC && options.mode != LogMode::MANUAL) {
+            conflict = "needs ASYNC or MANUAL mode";
+        } else if (options.topology != QueueTopology::SHARED) {
+            conflict = "needs QueueTopology::SHARED";
+        } else if (options.elastic_memory_cap > 0) {
+            conflict = "cannot be combined with elastic_memory_cap";
+        } else if (options.overflow == OverflowPolicy::SPILL) {
+            conflict = "cannot be combined with OverflowPolicy::SPILL";
+        }
+        if (conflict) {
+            throw std::invalid_argument(std::string("zerolog: persistent_path ") + conflict);
+        }
+    }
+
+    // Writes what a previous process left in the file, then starts it afresh.
+    void open_ring_file(const LoggerOptions& options) {
+        ring_file_ = std::make_unique<RingFile>(options.persistent_path);
+        bool replayed = false;
+        ring_file_->for_each_pending([&](const char* record, size_t len, uint64_t) {
+            if (record[0] != '\0') {
+                sink_.write({record, len});
+                replayed = true;
+            }
+        });
+        if (replayed) {
+            sink_.flush();
+        }
+        ring_file_->reset(ENTRY_SIZE, options.queue_capacity);
+    }
+
+    void create_queues(const LoggerOptions& options) {
+        if (ring_file_) {
+            add_ring(std::make_unique<Ring>(ENTRY_SIZE, options.queue_capacity, *ring_file_));
+            return;
+        }
+        // A single producer has nothing to spread across rings.
+        const QueueTopology topology = SINGLE_PRODUCER ? QueueTopology::SHARED : options.topology;
+        if (topology == QueueTopology::PER_NUMA_NODE) {
+            detail::NumaTopology numa = detail::numa_topology();
+            if (numa.nodes() > 1) {
+                size_t capacity = std::max<size_t>(options.queue_capacity / numa.nodes(), MIN_RING_CAPACITY);
+                for (const auto& cpus : numa.node_cpus) {
+                    add_ring(allocate_queue_on(cpus, capacity), cpus);
+                }
+                queue_of_cpu_ = numa.cpu_node;
+                return;
+            }
+        }
+        if (topology == QueueTopology::PER_CPU) {
+            long cpus = sysconf(_SC_NPROCESSORS_CONF);
+            size_t count = cpus > 0 ? static_cast<size_t>(cpus) : 1;
+            size_t capacity = std::max<size_t>(options.queue_capacity / count, MIN_RING_CAPACITY);
+            for (size_t cpu = 0; cpu < count; ++cpu) {
+                add_ring(allocate_queue_on({static_cast<int>(cpu)}, capacity), {static_cast<int>(cpu)});
+                queue_of_cpu_.push_back(static_cast<int>(cpu));
+            }
+            rseq_commit_ = detail::rseq_available();
+            return;
+        }
+        if (!options.worker.numa_local_queue || options.mode != LogMode::ASYNC) {
+            add_ring(std::make_unique<Ring>(ENTRY_SIZE, options.queue_capacity));
+        }
+    }
+
+    // The worker applies its placement options, allocates the ring itself when
+    // asked to (so first touch puts it on the worker's NUMA node) and reports
+    // back before the constructor returns.
+    void start_worker(const LoggerOptions& options) {
+        std::atomic<int> status{-1};
+        worker_ = std::make_unique<std::thread>([this, &options, &status] {
+            int err = detail::apply_worker_options(options.worker);
+            if (err == 0 && queues_.empty()) {
+                try {
+                    add_ring(std::make_unique<Ring>(ENTRY_SIZE, options.queue_capacity));
+                } catch (const std::bad_alloc&) {
+                    err = ENOMEM;
+                }
+            }
+            status.store(err, std::memory_order_release);
+            if (err == 0) {
+                worker_loop();
+            }
+        });
+        int err;
+        while ((err = status.load(std::memory_order_acquire)) < 0) {
+            std::this_thread::yield();
+        }
+        if (err != 0) {
+            worker_->join();
+            worker_.reset();
+            throw std::system_error(err, std::generic_category(), "zerolog worker options");
+        }
+    }
+
+public:
+    explicit Logger(Sink sink = {}, bool async = false)
+        : Logger(std::move(sink), options_for(async)) {}
+
+    Logger(Sink sink, const LoggerOptions& options)
+        : sink_(std::move(sink)),
+          reorder_window_(static_cast<uint64_t>(std::max<int64_t>(options.reorder_window.count(), 0))) {
+        if (!options.persistent_path.empty()) {
+            check_persistent_options(options);
+        }
+        if (options.mode == LogMode::SYNC) {
+            format_in_sink_ = provides_buffer_v<Sink>;
+            return;
+        }
+        if (options.mode == LogMode::CONCURRENT_SYNC) {
+            if constexpr (!is_thread_safe_v<Sink>) {
+                open_line_fd();
+            }
+            return;
+        }
+        if (options.queue_capacity == 0) {
+            throw std::invalid_argument("zerolog: queue_capacity must be at least 1");
+        }
+        if constexpr (has_write_batch_v<Sink> && !provides_buffer_v<Sink>) {
+            staged_ = std::make_unique<char[]>(DRAIN_BURST * ENTRY_SIZE);
+            staged_views_.reserve(DRAIN_BURST);
+        }
+        overflow_ = options.overflow;
+        // Deferred records point into this process; a persistent ring only holds text.
+        deferred_ = options.deferred && options.persistent_path.empty();
+        if (!options.persistent_path.empty()) {
+            open_ring_file(options);
+        }
+        if (options.elastic_memory_cap > 0) {
+            chunk_pool_ = std::make_unique<ChunkPool>(options.elastic_memory_cap);
+        }
+        if (overflow_ == OverflowPolicy::SPILL) {
+            spill_ = std::make_unique<SpillFile>(options.spill_path);
+        }
+        create_queues(options);
+        if (!rseq_commit_ && !SINGLE_PRODUCER && !ring_file_ && options.max_queue_capacity > 0) {
+            for (auto& queue : queues_) {
+                queue->enable_resize();
+            }
+            max_ring_capacity_ = options.max_queue_capacity;
+            shrink_after_ = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(options.shrink_after).count());
+        }
+        if (options.mode == LogMode::MANUAL) {
+            drain_owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+            event_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (event_fd_ < 0) {
+                throw std::system_error(errno, std::generic_category(), "eventfd");
+            }
+            return;
+        }
+        start_worker(options);
+    }
+    
+    ~Logger() {
+        if (worker_) {
+            running_ = false;
+            data_wait_.signal();
+            worker_->join();
+            worker_.reset();
+        }
+        drain_owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        flush();
+        if (event_fd_ >= 0) {
+            ::close(event_fd_);
+        }
+    }
+
+    // Records discarded under OverflowPolicy::DROP.
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    // MANUAL mode: readable whenever records are waiting for drain().
+    int event_fd() const { return event_fd_; }
+
+    // MANUAL mode: write up to max_records queued records to the sink,
+    // stopping early once max_time has elapsed. Call from a single thread,
+    // typically the event loop that polls event_fd(). Returns the number of
+    // records written; event_fd() stays readable if any are left. With a
+    // reorder_window, records younger than the window are held back and do
+    // not make event_fd() readable, so also call drain() on a timer of about
+    // that period. Other modes have a worker that owns the sink: there drain()
+    // asserts, and does nothing under NDEBUG.
+    size_t drain(size_t max_records = SIZE_MAX,
+                 std::chrono::nanoseconds max_time = std::chrono::nanoseconds::max()) {
+        assert(event_fd_ >= 0 && "drain() is for LogMode::MANUAL");
+        if (event_fd_ < 0) {
+            return 0;
+        }
+        drain_owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        return drain_queues(max_records, max_time, true);
+    }
+
+    // Replaces the sink without blocking producers. Records enqueued before
+    // the call go to the old sink, which is flushed and destroyed; later ones
+    // go to the new sink. In sync mode the caller must serialize with logging;
+    // in MANUAL mode, call it from the thread that calls drain().
+    void swap_sink(Sink sink) {
+        if (batch_.size() > 0) {
+            flush_batch();
+        }
+        if (!worker_) {
+            assert((event_fd_ < 0 || drain_owner_.load(std::memory_order_relaxed) == std::this_thread::get_id()) &&
+                   "swap_sink() in MANUAL mode from a thread other than the one calling drain()");
+            if (!queues_.empty()) {
+                drain_all();
+            }
+            if (line_fd_) {
+                flush();
+                std::swap(sink_, sink);
+                open_line_fd();
+                return;
+            }
+            sink_.flush();
+            std::swap(sink_, sink);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(swap_mtx_);
+        swap_cv_.wait(lock, [this] { return !pending_sink_; });
+        pending_sink_ = std::make_unique<Sink>(std::move(sink));
+        swap_sequences_.clear();
+        for (const auto& queue : queues_) {
+            swap_sequences_.push_back(queue->tail_sequence());
+        }
+        {
+            std::lock_guard<std::mutex> registry(elastic_mtx_);
+            for (const auto& entry : elastic_queues_) {
+                swap_sequences_.push_back(entry.second->tail_sequence());
+            }
+        }
+        spill_swap_sequence_ = spill_appended_.load(std::memory_order_acquire);
+        swap_pending_.store(true, std::memory_order_release);
+        data_wait_.signal();
+        swap_cv_.wait(lock, [this] { return !pending_sink_; });
+    }
+
+    // Only the level check and argument capture are inlined at the call site.
+    template<LogLevel L, typename... Args>
+    void log(fmt::format_string<Args...> fmt, Args&&... args) {
+        if constexpr (static_cast<int>(L) >= static_cast<int>(MinLevel)) {
+            emit<L>(fmt, std::forward<Args>(args)...);
+        }
+    }
+
+    // A categorized call is filtered by its category instead of MinLevel.
+    template<LogLevel L, typename Category, typename... Args>
+    void log(fmt::format_string<Args...> fmt, Args&&... args) {
+        if constexpr (static_cast<int>(L) >= static_cast<int>(Category::min_level)) {
+            if (category_enabled<Category>(L)) {
+                emit<L>(fmt, std::forward<Args>(args)...);
+            }
+        }
+    }
+
+    // In CONCURRENT_SYNC mode this emits every thread's pending lines.
+    void flush() {
+        if (line_fd_) {
+            detail::LineBuffer::emit_all(line_fd_);
+            return;
+        }
+        if (batch_.size() > 0) {
+            flush_batch();
+        }
+        if (worker_) {
+            uint64_t request = flush_requests_.fetch_add(1, std::memory_order_acq_rel) + 1;
+            data_wait_.signal();
+            while (flushes_done_.load(std::memory_order_acquire) < request) {
+                std::this_thread::yield();
+            }
+            return;
+        }
+        if (event_fd_ >= 0 && drain_owner_.load(std::memory_order_relaxed) != std::this_thread::get_id()) {
+            // MANUAL mode: only the event loop may touch the sink; wake it.
+            signal_drain();
+            return;
+        }
+        if (!queues_.empty()) {
+            drain_all();
+        }
+        sink_.flush();
+    }
+
+    // Type-erased handle for code that includes only log.hpp.
+    LogRef ref() {
+        return LogRef(this, MinLevel, &detail::vlog<Logger>, [](void* self) { static_cast<Logger*>(self)->flush(); });
+    }
+
+    template<typename... Args> void trace(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::TRACE>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void debug(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::DEBUG>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void info(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::INFO>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void warn(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::WARN>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void error(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::ERROR>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void critical(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::CRITICAL>(fmt, std::forward<Args>(args)...);}
+
+    // logger.debug<cat::net>(...): see Category in log.hpp.
+    template<typename Category, typename... Args> void trace(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::TRACE, Category>(fmt, std::forward<Args>(args)...);}
+    template<typename Category, typename... Args> void debug(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::DEBUG, Category>(fmt, std::forward<Args>(args)...);}
+    template<typename Category, typename... Args> void info(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::INFO, Category>(fmt, std::forward<Args>(args)...);}
+    template<typename Category, typename... Args> void warn(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::WARN, Category>(fmt, std::forward<Args>(args)...);}
+    template<typename Category, typename... Args> void error(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::ERROR, Category>(fmt, std::forward<Args>(args)...);}
+    template<typename Category, typename... Args> void critical(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::CRITICAL, Category>(fmt, std::forward<Args>(args)...);}
+};
+
+struct NullSink {
+    static constexpr bool thread_safe = true;
+    void write(std::string_view) {}
+    void flush() {}
+};
+
+// stdio locks the stream on every call; a batch takes the lock once.
+struct StdoutSink {
+    static constexpr bool thread_safe = true;
+    void write(std::string_view sv) { 
+        fwrite(sv.data(), 1, sv.size(), stdout); 
+    }
+    void write_batch(const std::string_view* records, size_t count) {
+        flockfile(stdout);
+        for (size_t i = 0; i < count; ++i) {
+            fwrite_unlocked(records[i].data(), 1, records[i].size(), stdout);
+        }
+        funlockfile(stdout);
+    }
+    void flush() { fflush(stdout); }
+};
+
+// Instantiated once, in src/logger.cpp.
+extern template class Logger<NullSink>;
+extern template class Logger<StdoutSink>;
+extern template void detail::vlog<Logger<NullSink>>(void*, LogLevel, fmt::string_view, fmt::format_args);
+extern template void detail::vlog<Logger<StdoutSink>>(void*, LogLevel, fmt::string_view, fmt::format_args);
 
 // ✅ FIX: Add factory function declarations
 std::shared_ptr<Logger<StdoutSink>> stdout_logger_mt(const char* name);
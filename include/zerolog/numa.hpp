@@ -0,0 +1,95 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+namespace zerolog {
+namespace detail {
+
+// NUMA layout read from sysfs. Nodes are renumbered densely, so node ids
+// with gaps (node0, node2) map to indices 0 and 1.
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus;
+    std::vector<int> cpu_node;
+
+    size_t nodes() const { return node_cpus.size(); }
+
+    int node_of(int cpu) const {
+        return cpu >= 0 && static_cast<size_t>(cpu) < cpu_node.size() ? cpu_node[cpu] : 0;
+    }
+};
+
+// Parses a kernel cpulist such as "0-3,8,10-11".
+inline std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string range = list.substr(pos, end - pos);
+        int first, last;
+        if (sscanf(range.c_str(), "%d-%d", &first, &last) == 2) {
+            for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+        } else if (sscanf(range.c_str(), "%d", &first) == 1) {
+            cpus.push_back(first);
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+inline NumaTopology numa_topology() {
+    NumaTopology topology;
+#if defined(__linux__)
+    std::vector<int> node_ids;
+    if (DIR* dir = opendir("/sys/devices/system/node")) {
+        while (dirent* entry = readdir(dir)) {
+            int id;
+            if (sscanf(entry->d_name, "node%d", &id) == 1) node_ids.push_back(id);
+        }
+        closedir(dir);
+    }
+    std::sort(node_ids.begin(), node_ids.end());
+    for (int id : node_ids) {
+        std::string path = "/sys/devices/system/node/node" + std::to_string(id) + "/cpulist";
+        char line[4096] = {};
+        if (FILE* f = fopen(path.c_str(), "r")) {
+            if (!fgets(line, sizeof(line), f)) line[0] = '\0';
+            fclose(f);
+        }
+        std::vector<int> cpus = parse_cpu_list(line);
+        if (cpus.empty()) continue;
+        for (int cpu : cpus) {
+            if (static_cast<size_t>(cpu) >= topology.cpu_node.size()) {
+                topology.cpu_node.resize(cpu + 1, 0);
+            }
+            topology.cpu_node[cpu] = static_cast<int>(topology.node_cpus.size());
+        }
+        topology.node_cpus.push_back(std::move(cpus));
+    }
+#endif
+    if (topology.node_cpus.empty()) {
+        unsigned n = std::max(1u, std::thread::hardware_concurrency());
+        topology.node_cpus.emplace_back();
+        for (unsigned cpu = 0; cpu < n; ++cpu) topology.node_cpus[0].push_back(static_cast<int>(cpu));
+        topology.cpu_node.assign(n, 0);
+    }
+    return topology;
+}
+
+inline int current_cpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#else
+    return 0;
+#endif
+}
+
+} // namespace detail
+} // namespace zerolog
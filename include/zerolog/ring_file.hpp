@@ -0,0 +1,156 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace zerolog {
+
+// Backing file for a crash-persistent ring (LoggerOptions::persistent_path):
+// a header page, then the slots in BasicRingBuffer's layout. Producers write
+// slots through a MAP_SHARED mapping, so a published record sits in the page
+// cache and outlives the process if it is killed (not a kernel crash or power
+// loss). The consumer clears a slot's length only after the record has gone
+// to the sink and the sink has been flushed, and stores the durable head
+// before producers may reuse the slot. Every slot with a nonzero length is
+// thus committed but not yet written, and its sequence follows from the head.
+// A record can be both written and still pending if the process died between
+// the flush and the release.
+class RingFile {
+public:
+    static constexpr size_t HEADER_SIZE = 4096;
+    static constexpr size_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(uint16_t);
+
+    struct Header {
+        char magic[8];
+        uint64_t entry_size;
+        uint64_t capacity;
+        std::atomic<uint64_t> head;  // first record not yet written to the sink
+    };
+
+    // Opens `path`, creating it if needed. A file that is not a valid ring
+    // reads as empty; a writable one is reinitialized by reset(). A writable
+    // RingFile holds an exclusive flock() for as long as it is open, and
+    // throws if another process (or logger) already has the file; a
+    // read-only one only checks, see in_use().
+    explicit RingFile(const std::string& path, bool writable = true) : writable_(writable) {
+        fd_ = writable ? ::open(path.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600)
+                       : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "zerolog ring file");
+        }
+        if (::flock(fd_, (writable ? LOCK_EX : LOCK_SH) | LOCK_NB) != 0) {
+            const int err = errno;
+            if (writable || err != EWOULDBLOCK) {
+                ::close(fd_);
+                throw std::system_error(err, std::generic_category(),
+                                        err == EWOULDBLOCK ? "zerolog ring file in use" : "zerolog ring file");
+            }
+            in_use_ = true;
+        }
+        struct stat st;
+        if (::fstat(fd_, &st) == 0 && static_cast<size_t>(st.st_size) >= HEADER_SIZE) {
+            map(static_cast<size_t>(st.st_size));
+            if (!valid()) {
+                unmap();
+            }
+        }
+    }
+
+    RingFile(const RingFile&) = delete;
+    RingFile& operator=(const RingFile&) = delete;
+
+    ~RingFile() {
+        unmap();
+        ::close(fd_);
+    }
+
+    // Calls fn(payload, len, timestamp) for every committed record not yet
+    // written, oldest first.
+    template<typename Fn>
+    void for_each_pending(Fn&& fn) const {
+        if (!mapping_) {
+            return;
+        }
+        const size_t entry_size = header()->entry_size;
+        const size_t capacity = header()->capacity;
+        const uint64_t head = header()->head.load(std::memory_order_acquire);
+        for (uint64_t seq = head; seq < head + capacity; ++seq) {
+            const char* slot = slots() + (seq % capacity) * entry_size;
+            uint16_t len;
+            uint64_t timestamp;
+            memcpy(&len, slot + entry_size - sizeof(len), sizeof(len));
+            memcpy(&timestamp, slot + entry_size - TRAILER_SIZE, sizeof(timestamp));
+            if (len != 0 && len <= entry_size - TRAILER_SIZE) {
+                fn(slot, static_cast<size_t>(len), timestamp);
+            }
+        }
+    }
+
+    // Writable files only: discards the contents and sizes the file for
+    // `capacity` slots of `entry_size` bytes, all free.
+    void reset(size_t entry_size, size_t capacity) {
+        unmap();
+        const size_t size = HEADER_SIZE + entry_size * capacity;
+        if (::ftruncate(fd_, 0) != 0 || ::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            throw std::system_error(errno, std::generic_category(), "zerolog ring file");
+        }
+        map(size);
+        Header* h = header();
+        h->entry_size = entry_size;
+        h->capacity = capacity;
+        h->head.store(0, std::memory_order_relaxed);
+        memcpy(h->magic, MAGIC, sizeof(MAGIC));
+    }
+
+    char* slots() const { return static_cast<char*>(mapping_) + HEADER_SIZE; }
+    std::atomic<uint64_t>& head() const { return header()->head; }
+    bool mapped() const { return mapping_ != nullptr; }
+    // Read-only files: a live logger has the file open, so its contents are
+    // still changing.
+    bool in_use() const { return in_use_; }
+
+private:
+    static constexpr char MAGIC[8] = "ZLRING1";
+    int fd_;
+    bool writable_;
+    bool in_use_ = false;
+    void* mapping_ = nullptr;
+    size_t size_ = 0;
+
+    Header* header() const { return static_cast<Header*>(mapping_); }
+
+    void map(size_t size) {
+        void* mapping = ::mmap(nullptr, size, writable_ ? PROT_READ | PROT_WRITE : PROT_READ,
+                               MAP_SHARED, fd_, 0);
+        if (mapping == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "zerolog ring file");
+        }
+        mapping_ = mapping;
+        size_ = size;
+    }
+
+    void unmap() {
+        if (mapping_) {
+            ::munmap(mapping_, size_);
+            mapping_ = nullptr;
+        }
+    }
+
+    bool valid() const {
+        const Header* h = header();
+        return memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0 && h->entry_size > TRAILER_SIZE &&
+               h->entry_size <= HEADER_SIZE && h->capacity > 0 &&
+               h->capacity <= (size_ - HEADER_SIZE) / h->entry_size &&
+               HEADER_SIZE + h->entry_size * h->capacity == size_;
+    }
+};
+
+} // namespace zerolog
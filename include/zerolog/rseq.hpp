@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#if defined(__linux__) && defined(__x86_64__) && defined(__has_include)
+#if __has_include(<sys/rseq.h>)
+#include <sys/rseq.h>
+#define ZEROLOG_HAS_RSEQ 1
+#endif
+#endif
+#ifndef ZEROLOG_HAS_RSEQ
+#define ZEROLOG_HAS_RSEQ 0
+#endif
+
+namespace zerolog {
+namespace detail {
+
+#if ZEROLOG_HAS_RSEQ
+
+#define ZEROLOG_STR_(x) #x
+#define ZEROLOG_STR(x) ZEROLOG_STR_(x)
+#define ZEROLOG_RSEQ_SIG_STR ZEROLOG_STR(RSEQ_SIG)
+
+// Restartable sequences registered by glibc (2.35+) for every thread.
+inline struct rseq* rseq_area() {
+    return reinterpret_cast<struct rseq*>(static_cast<char*>(__builtin_thread_pointer()) + __rseq_offset);
+}
+
+inline bool rseq_available() { return __rseq_size > 0; }
+
+inline int rseq_cpu() {
+    return static_cast<int>(__atomic_load_n(&rseq_area()->cpu_id, __ATOMIC_RELAXED));
+}
+
+// Copies len bytes (a multiple of 8) from src to dst and then stores
+// new_value to *word, all as one rseq critical section on `cpu`. Returns
+// false without committing if the thread is not on `cpu`, *word no longer
+// holds `expected`, or the section was preempted or migrated.
+inline bool rseq_copy_and_commit(int cpu, size_t* word, size_t expected, size_t new_value,
+                                 char* dst, const char* src, size_t len) {
+    struct rseq* rs = rseq_area();
+    size_t words = len / 8;
+    int aborted;
+    __asm__ __volatile__(
+        ".pushsection __rseq_cs, \"aw?\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0, 0\n\t"
+        ".quad 1f, (2f - 1f), 4f\n\t"
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %%rax\n\t"
+        "movq %%rax, %[rseq_cs]\n\t"
+        "1:\n\t"
+        "cmpl %[cpu], %[cpu_id]\n\t"
+        "jnz 4f\n\t"
+        "cmpq %[expected], %[word]\n\t"
+        "jnz 4f\n\t"
+        "test %[words], %[words]\n\t"
+        "jz 6f\n\t"
+        "5:\n\t"
+        "movq (%[src]), %%rax\n\t"
+        "movq %%rax, (%[dst])\n\t"
+        "addq $8, %[src]\n\t"
+        "addq $8, %[dst]\n\t"
+        "decq %[words]\n\t"
+        "jnz 5b\n\t"
+        "6:\n\t"
+        "movq %[new_value], %[word]\n\t"
+        "2:\n\t"
+        "xorl %[aborted], %[aborted]\n\t"
+        "jmp 7f\n\t"
+        ".pushsection __rseq_failure, \"ax?\"\n\t"
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long " ZEROLOG_RSEQ_SIG_STR "\n\t"
+        "4:\n\t"
+        "movl $1, %[aborted]\n\t"
+        "jmp 7f\n\t"
+        ".popsection\n\t"
+        "7:\n\t"
+        : [aborted] "=&r"(aborted), [src] "+r"(src), [dst] "+r"(dst), [words] "+r"(words),
+          [word] "+m"(*word), [rseq_cs] "=m"(rs->rseq_cs)
+        : [cpu] "r"(cpu), [cpu_id] "m"(rs->cpu_id), [expected] "r"(expected), [new_value] "r"(new_value)
+        : "memory", "cc", "rax");
+    return aborted == 0;
+}
+
+#else
+
+inline bool rseq_available() { return false; }
+inline int rseq_cpu() { return -1; }
+
+#endif
+
+} // namespace detail
+} // namespace zerolog
@@ -0,0 +1,56 @@
+#pragma once
+#include "zerolog/logger.hpp"
+#include "zerolog/sink_traits.hpp"
+
+namespace zerolog {
+
+// Synchronous logger for single-threaded programs: no thread-locals, no
+// atomics, no locks. With a sink that provides a buffer, records are
+// formatted straight into it and the sink only does I/O when it fills up
+// or is flushed.
+template<typename Sink, LogLevel MinLevel = LogLevel::TRACE>
+class SingleThreadLogger {
+private:
+    static constexpr size_t RESERVE = 256;
+    Sink sink_;
+    fmt::memory_buffer buf_;
+
+public:
+    explicit SingleThreadLogger(Sink sink = {}) : sink_(std::move(sink)) {}
+
+    ~SingleThreadLogger() { flush(); }
+
+    SingleThreadLogger(const SingleThreadLogger&) = delete;
+    SingleThreadLogger& operator=(const SingleThreadLogger&) = delete;
+
+    template<LogLevel L, typename... Args>
+    void log(fmt::format_string<Args...> fmt, Args&&... args) {
+        if constexpr (static_cast<int>(L) >= static_cast<int>(MinLevel)) {
+            auto now = std::chrono::steady_clock::now().time_since_epoch();
+            int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+            if constexpr (provides_buffer_v<Sink>) {
+                auto [out, room] = sink_.reserve(RESERVE);
+                size_t used;
+                if (detail::format_line(out, room, used, L, ns, fmt, fmt::make_format_args(args...))) {
+                    sink_.commit(used);
+                    return;
+                }
+            }
+            // Oversized record, or a sink without a buffer.
+            buf_.clear();
+            detail::format_record(buf_, L, ns, fmt, fmt::make_format_args(args...));
+            sink_.write({buf_.data(), buf_.size()});
+        }
+    }
+
+    void flush() { sink_.flush(); }
+
+    template<typename... Args> void trace(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::TRACE>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void debug(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::DEBUG>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void info(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::INFO>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void warn(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::WARN>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void error(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::ERROR>(fmt, std::forward<Args>(args)...);}
+    template<typename... Args> void critical(fmt::format_string<Args...> fmt, Args&&... args){log<LogLevel::CRITICAL>(fmt, std::forward<Args>(args)...);}
+};
+
+} // namespace zerolog
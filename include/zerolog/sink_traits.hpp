@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace zerolog {
+
+// Optional sink capabilities, detected at compile time. A sink only needs
+// write(std::string_view) and flush(); the logger picks a faster path for
+// each capability below that the sink has, with no runtime checks.
+
+// write_batch(const std::string_view* records, size_t count): the consumer
+// hands over up to a burst of records in one call instead of one write each.
+template<typename Sink, typename = void>
+struct has_write_batch : std::false_type {};
+
+template<typename Sink>
+struct has_write_batch<Sink, std::void_t<decltype(std::declval<Sink&>().write_batch(
+    std::declval<const std::string_view*>(), std::size_t{}))>> : std::true_type {};
+
+template<typename Sink>
+inline constexpr bool has_write_batch_v = has_write_batch<Sink>::value;
+
+// Buffer protocol: reserve(min_size) returns {char*, size_t} naming writable
+// space at the end of the sink's own buffer (at least min_size bytes, flushing
+// first if needed) and commit(size) keeps the first `size` bytes of it. The
+// consumer dequeues records straight into this space, and SYNC mode formats
+// into it.
+template<typename Sink, typename = void>
+struct provides_buffer : std::false_type {};
+
+template<typename Sink>
+struct provides_buffer<Sink, std::void_t<
+    decltype(std::declval<Sink&>().reserve(std::size_t{}).first),
+    decltype(std::declval<Sink&>().commit(std::size_t{}))>> : std::true_type {};
+
+template<typename Sink>
+inline constexpr bool provides_buffer_v = provides_buffer<Sink>::value;
+
+// fd() returns the descriptor the sink writes to.
+template<typename Sink, typename = void>
+struct exposes_fd : std::false_type {};
+
+template<typename Sink>
+struct exposes_fd<Sink, std::void_t<decltype(int{std::declval<const Sink&>().fd()})>> : std::true_type {};
+
+template<typename Sink>
+inline constexpr bool exposes_fd_v = exposes_fd<Sink>::value;
+
+// `static constexpr bool thread_safe = true`: write() and flush() may be called
+// from several threads at once, so CONCURRENT_SYNC writes straight to the sink.
+template<typename Sink, typename = void>
+struct is_thread_safe : std::false_type {};
+
+template<typename Sink>
+struct is_thread_safe<Sink, std::void_t<decltype(Sink::thread_safe)>>
+    : std::bool_constant<Sink::thread_safe> {};
+
+template<typename Sink>
+inline constexpr bool is_thread_safe_v = is_thread_safe<Sink>::value;
+
+// tick() is called on the consumer thread about every 10ms (by the worker, or
+// from drain() in MANUAL mode) for time-based work such as flushing a buffer
+// that has not filled up.
+template<typename Sink, typename = void>
+struct needs_periodic_tick : std::false_type {};
+
+template<typename Sink>
+struct needs_periodic_tick<Sink, std::void_t<decltype(std::declval<Sink&>().tick())>> : std::true_type {};
+
+template<typename Sink>
+inline constexpr bool needs_periodic_tick_v = needs_periodic_tick<Sink>::value;
+
+} // namespace zerolog
@@ -0,0 +1,121 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace zerolog {
+
+// Append-only overflow file for OverflowPolicy::SPILL. Each record is stored
+// as [uint16_t length | uint64_t timestamp | payload]. Writers append whole
+// buffers under the caller's lock; a single reader replays them in order
+// through a read-ahead buffer and rewinds the file once it has caught up.
+class SpillFile {
+public:
+    static constexpr size_t HEADER_SIZE = sizeof(uint16_t) + sizeof(uint64_t);
+
+    // An empty path spills to an unnamed temporary file in /tmp.
+    explicit SpillFile(const std::string& path) {
+        fd_ = path.empty() ? ::open("/tmp", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600)
+                           : ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0600);
+        if (fd_ < 0) {
+            throw std::system_error(errno, std::generic_category(), "zerolog spill file");
+        }
+    }
+
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+
+    ~SpillFile() { ::close(fd_); }
+
+    // Encodes one record into `out`; returns the bytes used.
+    static size_t encode(char* out, const char* payload, uint16_t len, uint64_t timestamp) {
+        memcpy(out, &len, sizeof(len));
+        memcpy(out + sizeof(len), &timestamp, sizeof(timestamp));
+        memcpy(out + HEADER_SIZE, payload, len);
+        return HEADER_SIZE + len;
+    }
+
+    // Writer side: false on an I/O error, in which case nothing is appended.
+    bool append(const char* data, size_t len) {
+        size_t end = end_.load(std::memory_order_relaxed);
+        size_t done = 0;
+        while (done < len) {
+            ssize_t n = ::pwrite(fd_, data + done, len - done, static_cast<off_t>(end + done));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        end_.store(end + len, std::memory_order_release);
+        return true;
+    }
+
+    // Reader side: the next record, or false once everything appended so far
+    // has been read. A read error skips what is left of the file.
+    bool read_next(char* payload, size_t& len, uint64_t& timestamp) {
+        for (;;) {
+            size_t buffered = buffer_end_ - buffer_begin_;
+            if (buffered >= HEADER_SIZE) {
+                const char* record = buffer_.get() + buffer_begin_;
+                uint16_t record_len;
+                memcpy(&record_len, record, sizeof(record_len));
+                if (buffered >= HEADER_SIZE + record_len) {
+                    memcpy(&timestamp, record + sizeof(record_len), sizeof(timestamp));
+                    memcpy(payload, record + HEADER_SIZE, record_len);
+                    len = record_len;
+                    buffer_begin_ += HEADER_SIZE + record_len;
+                    return true;
+                }
+            }
+            size_t end = end_.load(std::memory_order_acquire);
+            if (read_offset_ == end) {
+                return false;
+            }
+            memmove(buffer_.get(), buffer_.get() + buffer_begin_, buffered);
+            buffer_begin_ = 0;
+            buffer_end_ = buffered;
+            ssize_t n = ::pread(fd_, buffer_.get() + buffer_end_,
+                                std::min(BUFFER_SIZE - buffer_end_, end - read_offset_),
+                                static_cast<off_t>(read_offset_));
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                read_offset_ = end;
+                buffer_begin_ = buffer_end_ = 0;
+                return false;
+            }
+            read_offset_ += static_cast<size_t>(n);
+            buffer_end_ += static_cast<size_t>(n);
+        }
+    }
+
+    bool caught_up() const {
+        return buffer_begin_ == buffer_end_ && read_offset_ == end_.load(std::memory_order_acquire);
+    }
+
+    // Reader side, with writers excluded: drops the replayed contents.
+    void reset() {
+        [[maybe_unused]] int rc = ::ftruncate(fd_, 0);
+        end_.store(0, std::memory_order_relaxed);
+        read_offset_ = 0;
+        buffer_begin_ = buffer_end_ = 0;
+    }
+
+private:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+    int fd_;
+    std::atomic<size_t> end_{0};
+    size_t read_offset_ = 0;
+    std::unique_ptr<char[]> buffer_ = std::make_unique<char[]>(BUFFER_SIZE);
+    size_t buffer_begin_ = 0;
+    size_t buffer_end_ = 0;
+};
+
+} // namespace zerolog
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace zerolog {
+namespace detail {
+
+// Out-of-line storage for std::string arguments moved into deferred records.
+// A producer thread takes nodes from its own pool; the consumer hands each
+// one back once its record is formatted. A pool is freed when its thread has
+// exited and every node it gave out is back.
+class StringPool {
+public:
+    struct Node {
+        std::string value;
+        Node* next = nullptr;
+        StringPool* pool = nullptr;
+    };
+
+    // Producer side: moves `value` into a node; no bytes are copied.
+    static Node* take(std::string&& value) {
+        StringPool& pool = local().get();
+        Node* node = pool.free_;
+        if (!node) {
+            node = pool.returned_.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (node) {
+            pool.free_ = node->next;
+        } else {
+            node = new Node;
+            node->pool = &pool;
+        }
+        pool.refs_.fetch_add(1, std::memory_order_relaxed);
+        node->value = std::move(value);
+        return node;
+    }
+
+    // Consumer side: frees the string and returns the node to its pool.
+    static void give_back(Node* node) {
+        std::string().swap(node->value);
+        StringPool* pool = node->pool;
+        node->next = pool->returned_.load(std::memory_order_relaxed);
+        while (!pool->returned_.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                                      std::memory_order_relaxed)) {
+        }
+        pool->unref();
+    }
+
+private:
+    Node* free_ = nullptr;
+    std::atomic<Node*> returned_{nullptr};
+    std::atomic<size_t> refs_{1};  // the owning thread plus each node out
+
+    StringPool() = default;
+
+    ~StringPool() {
+        for (Node* list : {free_, returned_.load(std::memory_order_acquire)}) {
+            while (list) {
+                delete std::exchange(list, list->next);
+            }
+        }
+    }
+
+    void unref() {
+        if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    struct Local {
+        StringPool* pool = nullptr;
+        StringPool& get() { return pool ? *pool : *(pool = new StringPool); }
+        ~Local() {
+            if (pool) pool->unref();
+        }
+    };
+
+    static Local& local() {
+        thread_local Local local;
+        return local;
+    }
+};
+
+// A decoded string argument: a view into the record, or into a pooled node
+// that goes back to its pool when this is destroyed.
+class CapturedString {
+public:
+    explicit CapturedString(std::string_view view) : view_(view) {}
+    explicit CapturedString(StringPool::Node* node) : view_(node->value), node_(node) {}
+    CapturedString(CapturedString&& other) noexcept
+        : view_(other.view_), node_(std::exchange(other.node_, nullptr)) {}
+    CapturedString(const CapturedString&) = delete;
+    CapturedString& operator=(const CapturedString&) = delete;
+    ~CapturedString() {
+        if (node_) StringPool::give_back(node_);
+    }
+
+    std::string_view view() const { return view_; }
+
+private:
+    std::string_view view_;
+    StringPool::Node* node_ = nullptr;
+};
+
+} // namespace detail
+} // namespace zerolog
@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace zerolog {
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+namespace detail {
+
+inline void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, std::chrono::nanoseconds timeout) {
+#if defined(__linux__)
+    timespec ts{static_cast<time_t>(timeout.count() / 1'000'000'000),
+                static_cast<long>(timeout.count() % 1'000'000'000)};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::sleep_for(timeout);
+    }
+#endif
+}
+
+inline void futex_wake_all(std::atomic<uint32_t>& word) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT32_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+} // namespace detail
+
+// Wait strategies decide how one side of the queue waits for the other:
+// the worker for records, producers for free slots. wait(ready) returns once
+// ready() holds or after a bounded park, so callers loop on their own
+// condition; signal() is called after the condition may have become true.
+
+// Never yields the core. Lowest latency; pin the worker when using it.
+struct BusySpinWait {
+    template<typename Ready>
+    void wait(Ready&& ready) {
+        while (!ready()) {
+            cpu_relax();
+        }
+    }
+    void signal() {}
+};
+
+// Spins briefly, then gives the core away with sched_yield.
+struct YieldingWait {
+    static constexpr int SPIN_TRIES = 128;
+
+    template<typename Ready>
+    void wait(Ready&& ready) {
+        for (int i = 0; !ready(); ++i) {
+            if (i < SPIN_TRIES) {
+                cpu_relax();
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+    void signal() {}
+};
+
+// Spins, then parks on a futex. signal() costs one fence and one load unless
+// someone is actually parked.
+struct SpinParkWait {
+    static constexpr int SPIN_TRIES = 256;
+    static constexpr std::chrono::milliseconds PARK_TIMEOUT{10};
+    alignas(64) std::atomic<uint32_t> epoch_{0};
+    std::atomic<uint32_t> sleepers_{0};
+
+    template<typename Ready>
+    void wait(Ready&& ready) {
+        for (int i = 0; i < SPIN_TRIES; ++i) {
+            if (ready()) return;
+            cpu_relax();
+        }
+        uint32_t epoch = epoch_.load(std::memory_order_acquire);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        if (!ready()) {
+            detail::futex_wait(epoch_, epoch, PARK_TIMEOUT);
+        }
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void signal() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) != 0) {
+            epoch_.fetch_add(1, std::memory_order_release);
+            detail::futex_wake_all(epoch_);
+        }
+    }
+};
+
+// Blocks on a condition variable straight away. Cheapest on CPU for batch
+// jobs and mostly idle services.
+struct BlockingWait {
+    static constexpr std::chrono::milliseconds PARK_TIMEOUT{1};
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::atomic<uint32_t> sleepers_{0};
+
+    template<typename Ready>
+    void wait(Ready&& ready) {
+        if (ready()) return;
+        std::unique_lock<std::mutex> lock(mtx_);
+        sleepers_.fetch_add(1, std::memory_order_seq_cst);
+        cv_.wait_for(lock, PARK_TIMEOUT, ready);
+        sleepers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void signal() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<std::mutex> lock(mtx_);
+            cv_.notify_all();
+        }
+    }
+};
+
+} // namespace zerolog
@@ -0,0 +1,68 @@
+#pragma once
+#include <cerrno>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace zerolog {
+
+// Placement of the logger's worker thread. Defaults leave everything as
+// inherited from the constructing thread.
+struct WorkerOptions {
+    std::vector<int> cpus;        // CPU affinity; empty keeps the inherited mask
+    int sched_policy = -1;        // SCHED_OTHER, SCHED_BATCH, SCHED_IDLE, SCHED_FIFO, SCHED_RR; -1 keeps it
+    int sched_priority = 0;       // static priority for SCHED_FIFO/SCHED_RR
+    int nice = 0;                 // per-thread nice value; 0 keeps it
+    int ioprio_class = 0;         // 1 = RT, 2 = BE, 3 = IDLE; 0 keeps it
+    int ioprio_level = 4;         // 0 (highest) .. 7 within the class
+    std::string name;             // thread name, truncated to 15 characters
+    bool numa_local_queue = false; // first-touch the ring from the worker so it lands on the worker's node
+};
+
+namespace detail {
+
+// Applies options to the calling thread. Returns 0 or an errno value.
+inline int apply_worker_options(const WorkerOptions& options) {
+#if defined(__linux__)
+    if (!options.name.empty()) {
+        pthread_setname_np(pthread_self(), options.name.substr(0, 15).c_str());
+    }
+    if (!options.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : options.cpus) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) return EINVAL;
+            CPU_SET(cpu, &set);
+        }
+        if (int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) return rc;
+    }
+    if (options.sched_policy >= 0) {
+        sched_param param{};
+        param.sched_priority = options.sched_priority;
+        if (int rc = pthread_setschedparam(pthread_self(), options.sched_policy, &param)) return rc;
+    }
+    const pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    if (options.nice != 0 && setpriority(PRIO_PROCESS, static_cast<id_t>(tid), options.nice) != 0) {
+        return errno;
+    }
+    if (options.ioprio_class != 0) {
+        constexpr int IOPRIO_WHO_PROCESS = 1;
+        constexpr int IOPRIO_CLASS_SHIFT = 13;
+        int prio = (options.ioprio_class << IOPRIO_CLASS_SHIFT) | options.ioprio_level;
+        if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, tid, prio) != 0) return errno;
+    }
+    return 0;
+#else
+    return options.cpus.empty() && options.sched_policy < 0 && options.nice == 0 &&
+           options.ioprio_class == 0 ? 0 : ENOTSUP;
+#endif
+}
+
+} // namespace detail
+} // namespace zerolog
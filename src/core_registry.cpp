@@ -0,0 +1,39 @@
+#include "zerolog/core_registry.hpp"
+#include <mutex>
+
+// Initialized at compile time, so the magic lives in the (dumped) data
+// segment rather than only in read-only data.
+extern "C" {
+__attribute__((used, visibility("default")))
+zerolog::detail::CoreRoot zerolog_core_root = {"zerolog-core-v1", zerolog::detail::CORE_VERSION,
+                                               sizeof(uint64_t) + sizeof(uint16_t), 0};
+}
+
+namespace zerolog {
+namespace detail {
+
+namespace {
+std::mutex core_mtx;
+}
+
+// Each update is one pointer store, so a process that dies mid-update still
+// leaves a well-formed list.
+void core_register(CoreRegion& region) {
+    std::lock_guard<std::mutex> lock(core_mtx);
+    region.next = zerolog_core_root.regions;
+    __atomic_store_n(&zerolog_core_root.regions, reinterpret_cast<uintptr_t>(&region), __ATOMIC_RELEASE);
+}
+
+void core_unregister(CoreRegion& region) {
+    std::lock_guard<std::mutex> lock(core_mtx);
+    uint64_t* link = &zerolog_core_root.regions;
+    while (*link && *link != reinterpret_cast<uintptr_t>(&region)) {
+        link = &reinterpret_cast<CoreRegion*>(*link)->next;
+    }
+    if (*link) {
+        __atomic_store_n(link, region.next, __ATOMIC_RELEASE);
+    }
+}
+
+} // namespace detail
+} // namespace zerolog
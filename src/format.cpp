@@ -0,0 +1,41 @@
+#include "zerolog/logger.hpp"
+
+namespace zerolog {
+namespace detail {
+
+namespace {
+constexpr const char levels[] = "TDIWEC";
+}
+
+void format_prefix(fmt::memory_buffer& buf, LogLevel level, int64_t ns) {
+    fmt::format_to(std::back_inserter(buf), "{}.{:09} {} ",
+                   ns / 1'000'000'000, ns % 1'000'000'000, levels[static_cast<int>(level)]);
+}
+
+void format_record(fmt::memory_buffer& buf, LogLevel level, int64_t ns,
+                   fmt::string_view fmt, fmt::format_args args) {
+    format_prefix(buf, level, ns);
+    fmt::vformat_to(std::back_inserter(buf), fmt, args);
+    buf.push_back('\n');
+}
+
+bool format_line(char* out, size_t room, size_t& used, LogLevel level, int64_t ns,
+                 fmt::string_view fmt, fmt::format_args args) {
+    auto prefix = fmt::format_to_n(out, room, "{}.{:09} {} ",
+                                   ns / 1'000'000'000, ns % 1'000'000'000, levels[static_cast<int>(level)]);
+    if (prefix.size >= room) return false;
+    auto body = fmt::vformat_to_n(prefix.out, room - prefix.size, fmt, args);
+    used = prefix.size + body.size;
+    if (used >= room) return false;
+    out[used++] = '\n';
+    return true;
+}
+
+void format_error_record(fmt::memory_buffer& buf, LogLevel level, int64_t ns,
+                         fmt::string_view fmt, const char* what) {
+    format_prefix(buf, level, ns);
+    fmt::format_to(std::back_inserter(buf), "[format error: {}] {}\n", what, fmt);
+}
+
+} // namespace detail
+} // namespace zerolog
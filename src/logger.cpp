@@ -4,8 +4,10 @@
 namespace zerolog {
 
 // Explicit instantiations for common configurations
-template class Logger<NullSink, LogLevel::TRACE>;
-template class Logger<StdoutSink, LogLevel::TRACE>;
+template class Logger<NullSink>;
+template class Logger<StdoutSink>;
+template void detail::vlog<Logger<NullSink>>(void*, LogLevel, fmt::string_view, fmt::format_args);
+template void detail::vlog<Logger<StdoutSink>>(void*, LogLevel, fmt::string_view, fmt::format_args);
 
 // Factory functions
 std::shared_ptr<Logger<StdoutSink>> stdout_logger_mt(const char* name) {
@@ -0,0 +1,111 @@
+#include "zerolog/logger.hpp"
+#include "test_support.hpp"
+#include <cerrno>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A process dies with records in its ring and in a thread's batch; its core
+// file goes through zerolog_core_extract. So as not to depend on the
+// system's core dump settings, the process writes the core itself: an ELF
+// core with a PT_LOAD segment per writable mapping, which is all the tool
+// reads.
+// Usage: zerolog_core_extract_test <path to zerolog_core_extract>
+namespace {
+
+using namespace zerolog;
+using namespace zerolog_test;
+constexpr int THREADS = 2, RECORDS = 500;
+
+struct Mapping {
+    uint64_t start, end;
+};
+
+// Segment contents are written straight from memory, never through a
+// buffer that would itself end up in the core.
+void write_core(const std::string& path) {
+    std::vector<Mapping> mappings;
+    FILE* maps = fopen("/proc/self/maps", "r");
+    expect(maps != nullptr, "open /proc/self/maps");
+    char line[512];
+    while (fgets(line, sizeof(line), maps)) {
+        unsigned long start, end;
+        char perms[5];
+        if (sscanf(line, "%lx-%lx %4s", &start, &end, perms) == 3 && perms[0] == 'r' && perms[1] == 'w') {
+            mappings.push_back({start, end});
+        }
+    }
+    fclose(maps);
+
+    Elf64_Ehdr ehdr{};
+    memcpy(ehdr.e_ident, ELFMAG, SELFMAG);
+    ehdr.e_ident[EI_CLASS] = ELFCLASS64;
+    ehdr.e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr.e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr.e_type = ET_CORE;
+    ehdr.e_version = EV_CURRENT;
+    ehdr.e_phoff = sizeof(ehdr);
+    ehdr.e_ehsize = sizeof(ehdr);
+    ehdr.e_phentsize = sizeof(Elf64_Phdr);
+    ehdr.e_phnum = static_cast<Elf64_Half>(mappings.size());
+
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    expect(fd >= 0, "create core", strerror(errno));
+    expect(::pwrite(fd, &ehdr, sizeof(ehdr), 0) == sizeof(ehdr), "write ELF header");
+    uint64_t offset = sizeof(ehdr) + mappings.size() * sizeof(Elf64_Phdr);
+    for (size_t i = 0; i < mappings.size(); ++i) {
+        Elf64_Phdr phdr{};
+        phdr.p_type = PT_LOAD;
+        phdr.p_flags = PF_R | PF_W;
+        phdr.p_offset = offset;
+        phdr.p_vaddr = mappings[i].start;
+        phdr.p_filesz = phdr.p_memsz = mappings[i].end - mappings[i].start;
+        expect(::pwrite(fd, &phdr, sizeof(phdr), static_cast<off_t>(sizeof(ehdr) + i * sizeof(phdr))) ==
+               sizeof(phdr), "write program header");
+        // Pages that cannot be read (EFAULT) stay a hole of zeros.
+        for (uint64_t done = 0; done < phdr.p_filesz;) {
+            ssize_t n = ::pwrite(fd, reinterpret_cast<const char*>(phdr.p_vaddr + done),
+                                 phdr.p_filesz - done, static_cast<off_t>(offset + done));
+            done += n > 0 ? static_cast<uint64_t>(n) : 4096;
+        }
+        offset += phdr.p_filesz;
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    expect(argc == 2, "usage", "zerolog_core_extract_test <zerolog_core_extract>");
+    const std::string path = "/tmp/zerolog_core_test." + std::to_string(getpid());
+
+    // MANUAL mode with nothing drained: the other thread's records are in
+    // the ring, and this thread's last partial batch is still its own.
+    const pid_t child = fork();
+    expect(child >= 0, "fork");
+    if (child == 0) {
+        LoggerOptions options;
+        options.mode = LogMode::MANUAL;
+        options.queue_capacity = 4096;
+        std::string unused;
+        Logger<CaptureSink> logger(CaptureSink{&unused}, options);
+        std::thread([&logger] {
+            for (int i = 0; i < RECORDS; ++i) logger.info("t1 {}", i);
+            logger.flush();
+        }).join();
+        for (int i = 0; i < RECORDS; ++i) logger.info("t0 {}", i);
+        write_core(path);
+        _exit(0);
+    }
+    int status = 0;
+    expect(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0, "child");
+
+    const std::string text = run(std::string(argv[1]) + " " + path);
+    ::unlink(path.c_str());
+    expect_sequences(text, THREADS, RECORDS, "zerolog_core_extract");
+    printf("core extract: %d records\n", THREADS * RECORDS);
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "zerolog/logger.hpp"
+#include "test_support.hpp"
+
+// Records that do not fit the ring go to elastic chunk queues, which the
+// worker merges with the ring; none are lost and each thread's stay in order.
+namespace {
+
+using namespace zerolog;
+using namespace zerolog_test;
+constexpr int THREADS = 4, RECORDS = 20000;
+
+} // namespace
+
+int main() {
+    // Several sources, so that the merge and its reorder window apply too.
+    LoggerOptions elastic;
+    elastic.elastic_memory_cap = 4 << 20;
+    elastic.reorder_window = std::chrono::microseconds(200);
+    overflow_round_trip(elastic, THREADS, RECORDS, "elastic queues");
+
+    elastic.reorder_window = std::chrono::microseconds(0);
+    overflow_round_trip(elastic, THREADS, RECORDS, "elastic queues, no reorder window");
+    return 0;
+}
@@ -0,0 +1,23 @@
+#include "zerolog/logger.hpp"
+#include "test_support.hpp"
+
+// PER_CPU rings, committed with rseq where the kernel supports it: records
+// from threads that migrate between CPUs all reach the sink, in order.
+int main() {
+    using namespace zerolog;
+    using namespace zerolog_test;
+    constexpr int THREADS = 8, RECORDS = 20000;
+
+    std::string text;
+    {
+        LoggerOptions options;
+        options.mode = LogMode::ASYNC;
+        options.topology = QueueTopology::PER_CPU;
+        options.queue_capacity = 1024;
+        Logger<CaptureSink> logger(CaptureSink{&text}, options);
+        log_from_threads(logger, THREADS, RECORDS);
+    }
+    expect_sequences(text, THREADS, RECORDS, "per-CPU rings");
+    printf("per-CPU: %s, %d records\n", detail::rseq_available() ? "rseq" : "CAS", THREADS * RECORDS);
+    return 0;
+}
@@ -0,0 +1,97 @@
+#include "zerolog/logger.hpp"
+#include "test_support.hpp"
+#include <csignal>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A process dies with records still in its persistent ring: zerolog_recover
+// prints them, and the next logger on the file writes them first.
+// Usage: zerolog_persistent_recover_test <path to zerolog_recover>
+namespace {
+
+using namespace zerolog;
+using namespace zerolog_test;
+constexpr int THREADS = 2, RECORDS = 500;
+
+LoggerOptions persistent(const std::string& path, LogMode mode) {
+    LoggerOptions options;
+    options.mode = mode;
+    options.queue_capacity = 4096;
+    options.persistent_path = path;
+    return options;
+}
+
+// Never returns from a write, so the worker releases nothing.
+struct StuckSink {
+    void write(std::string_view) { pause(); }
+    void flush() {}
+};
+
+// Runs `child` in a forked process, which must end it without returning,
+// and checks how it ended.
+template<typename Child>
+void in_child(Child child, bool killed) {
+    const pid_t pid = fork();
+    expect(pid >= 0, "fork");
+    if (pid == 0) {
+        child();
+        _exit(1);
+    }
+    int status = 0;
+    expect(waitpid(pid, &status, 0) == pid, "waitpid");
+    if (killed) {
+        expect(WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL, "child not killed");
+    } else {
+        expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "child failed");
+    }
+}
+
+void recover(const char* zerolog_recover, const std::string& path, const char* what) {
+    expect_sequences(run(std::string(zerolog_recover) + " " + path), THREADS, RECORDS, what);
+
+    std::string text;
+    {
+        Logger<CaptureSink> logger(CaptureSink{&text}, persistent(path, LogMode::MANUAL));
+    }
+    expect_sequences(text, THREADS, RECORDS, what);
+    expect_sequences(run(std::string(zerolog_recover) + " " + path), THREADS, 0, what);
+    ::unlink(path.c_str());
+    printf("%s: %d records recovered\n", what, THREADS * RECORDS);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    expect(argc == 2, "usage", "zerolog_persistent_recover_test <zerolog_recover>");
+    const std::string path = "/tmp/zerolog_recover_test." + std::to_string(getpid());
+
+    // Nothing is drained: MANUAL mode only writes from drain(), and flush()
+    // from a thread other than the drain owner just publishes its batch.
+    in_child([&path] {
+        std::string unused;
+        Logger<CaptureSink> logger(CaptureSink{&unused}, persistent(path, LogMode::MANUAL));
+        log_from_threads(logger, THREADS, RECORDS);
+        _exit(0);  // before ~Logger drains the ring
+    }, false);
+    recover(argv[1], path, "MANUAL");
+
+    // Killed while the worker is stuck in the sink, with nothing flushed by
+    // the producers: every record must already be in the file.
+    in_child([&path] {
+        Logger<StuckSink> logger(StuckSink{}, persistent(path, LogMode::ASYNC));
+        std::vector<std::thread> producers;
+        for (int t = 0; t < THREADS; ++t) {
+            producers.emplace_back([&logger, t] {
+                for (int i = 0; i < RECORDS; ++i) logger.info("t{} {}", t, i);
+            });
+        }
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        raise(SIGKILL);
+    }, true);
+    recover(argv[1], path, "ASYNC, killed");
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include "zerolog/logger.hpp"
+#include "test_support.hpp"
+
+// The ring grows under a slow sink and shrinks again once idle; no record
+// is lost across a resize and each thread's stay in order.
+namespace {
+
+using namespace zerolog;
+using namespace zerolog_test;
+constexpr int THREADS = 4, RECORDS = 20000;
+
+} // namespace
+
+int main() {
+    LoggerOptions growth;
+    growth.max_queue_capacity = 4096;
+    growth.shrink_after = std::chrono::milliseconds(20);
+    overflow_round_trip(growth, THREADS, RECORDS, "ring growth");
+
+    // The ring is then allocated by the worker once it has started.
+    growth.worker.numa_local_queue = true;
+    overflow_round_trip(growth, THREADS, RECORDS, "ring growth, worker-allocated ring");
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include "zerolog/logger.hpp"
+#include "zerolog/sinks/file_sink.hpp"
+#include "test_support.hpp"
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+// FileSink provides its buffer: records are formatted or dequeued straight
+// into it, and lines that do not fit what it reserved are written through
+// write() instead. Either way the file must hold exactly the logged bytes.
+namespace {
+
+using namespace zerolog;
+using namespace zerolog_test;
+constexpr int RECORDS = 600;
+// Around SINK_RESERVE and ENTRY_SIZE, and past FileSink's 64 KiB buffer.
+constexpr int WIDTHS[] = {1, 200, 250, 400, 3000, 70000};
+constexpr size_t MAX_RECORD = 256 - LockFreeRingBuffer::TRAILER_SIZE;
+
+std::string body(int i) {
+    const int width = WIDTHS[i % std::size(WIDTHS)];
+    return fmt::format("r{} {:>{}}", i, i, width);
+}
+
+// `truncated`: the record was formatted before it was queued, so a line
+// longer than a queue entry was cut to MAX_RECORD bytes, newline included.
+void round_trip(LoggerOptions options, bool truncated, const char* what) {
+    const std::string path = "/tmp/zerolog_sink_buffer_test." + std::to_string(getpid());
+    {
+        Logger<FileSink> logger(FileSink(path.c_str(), true), options);
+        for (int i = 0; i < RECORDS; ++i) {
+            const int width = WIDTHS[i % std::size(WIDTHS)];
+            logger.info("r{} {:>{}}", i, i, width);
+        }
+    }
+    std::ifstream file(path, std::ios::binary);
+    const std::string text{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    ::unlink(path.c_str());
+
+    size_t at = 0;
+    for (int i = 0; i < RECORDS; ++i) {
+        const std::string context = "record " + std::to_string(i);
+        const size_t end = text.find('\n', at);
+        expect(end != std::string::npos, what, context + ": missing");
+        const std::string line = text.substr(at, end + 1 - at);
+        at = end + 1;
+
+        // "<seconds>.<nanoseconds> I <body>\n"
+        const size_t dot = line.find('.');
+        expect(dot != std::string::npos && dot > 0 && line.size() > dot + 13 &&
+               line.compare(dot + 10, 3, " I ") == 0, what, context + ": bad prefix");
+        std::string expected = line.substr(0, dot + 13) + body(i) + "\n";
+        if (truncated && expected.size() > MAX_RECORD) {
+            expected.resize(MAX_RECORD);
+            expected.back() = '\n';
+        }
+        expect(line == expected, what,
+               context + ": " + std::to_string(line.size()) + " bytes, expected " +
+               std::to_string(expected.size()));
+    }
+    expect(at == text.size(), what, "bytes after the last record");
+    printf("%s: %d records, %zu bytes\n", what, RECORDS, text.size());
+}
+
+} // namespace
+
+int main() {
+    LoggerOptions sync;
+    sync.mode = LogMode::SYNC;
+    round_trip(sync, false, "SYNC, formatted into the sink");
+
+    LoggerOptions async;
+    async.mode = LogMode::ASYNC;
+    async.queue_capacity = 1024;
+    round_trip(async, true, "ASYNC, dequeued into the sink");
+
+    async.deferred = true;
+    round_trip(async, false, "ASYNC deferred, formatted into the sink");
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include "zerolog/logger.hpp"
+#include "test_support.hpp"
+#include <csignal>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Records that do not fit the ring go through the SPILL file; none are lost
+// and each thread's stay in order, even when writes to the file fail.
+namespace {
+
+using namespace zerolog;
+using namespace zerolog_test;
+constexpr int THREADS = 4, RECORDS = 20000;
+
+} // namespace
+
+int main() {
+    LoggerOptions spill;
+    spill.overflow = OverflowPolicy::SPILL;
+    overflow_round_trip(spill, THREADS, RECORDS, "SPILL replay");
+
+    // Appends past 64 KiB fail with EFBIG, after some of a thread's records
+    // are already in the file.
+    const std::string path = "/tmp/zerolog_spill_test." + std::to_string(getpid());
+    signal(SIGXFSZ, SIG_IGN);
+    rlimit limit{64 << 10, 64 << 10};
+    expect(setrlimit(RLIMIT_FSIZE, &limit) == 0, "setrlimit");
+    spill.spill_path = path;
+    overflow_round_trip(spill, THREADS, RECORDS, "SPILL replay, failing writes");
+    ::unlink(path.c_str());
+    return 0;
+}
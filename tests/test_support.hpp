@@ -0,0 +1,111 @@
+#pragma once
+#include "zerolog/logger.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Shared by the programs under tests/: each logs "t<thread> <sequence>"
+// records from several threads and checks that every one arrived once, in
+// order per thread. A failed check prints what went wrong and exits with 1.
+namespace zerolog_test {
+
+// Keeps everything written; `delay` slows each write so that queues fill.
+struct CaptureSink {
+    std::string* text;
+    std::chrono::nanoseconds delay{0};
+
+    void write(std::string_view record) {
+        text->append(record);
+        if (delay.count() > 0) {
+            const auto until = std::chrono::steady_clock::now() + delay;
+            while (std::chrono::steady_clock::now() < until) {
+            }
+        }
+    }
+    void flush() {}
+};
+
+[[noreturn]] inline void fail(const char* what, const std::string& detail) {
+    fprintf(stderr, "FAIL %s: %s\n", what, detail.c_str());
+    exit(1);
+}
+
+inline void expect(bool condition, const char* what, const std::string& detail = {}) {
+    if (!condition) fail(what, detail);
+}
+
+// Each thread logs per_thread records and flushes its own batch.
+template<typename Logger>
+void log_from_threads(Logger& logger, int threads, int per_thread) {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&logger, t, per_thread] {
+            for (int i = 0; i < per_thread; ++i) {
+                logger.info("t{} {}", t, i);
+            }
+            logger.flush();
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+// Lines of `text` that are not records are ignored.
+inline void expect_sequences(const std::string& text, int threads, int per_thread, const char* what) {
+    std::vector<int> next(threads, 0);
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        const size_t at = line.find(" t");
+        int thread, sequence;
+        if (at == std::string::npos || sscanf(line.c_str() + at, " t%d %d", &thread, &sequence) != 2) {
+            continue;
+        }
+        expect(thread >= 0 && thread < threads, what, "unknown thread in: " + line);
+        expect(sequence == next[thread], what,
+               "thread " + std::to_string(thread) + ": expected " + std::to_string(next[thread]) +
+               ", got " + std::to_string(sequence));
+        ++next[thread];
+    }
+    for (int t = 0; t < threads; ++t) {
+        expect(next[t] == per_thread, what,
+               "thread " + std::to_string(t) + ": " + std::to_string(next[t]) + " of " +
+               std::to_string(per_thread) + " records");
+    }
+}
+
+// ASYNC mode through a sink slow enough for a 256-entry ring to overflow.
+inline void overflow_round_trip(zerolog::LoggerOptions options, int threads, int per_thread,
+                                const char* what) {
+    std::string text;
+    {
+        options.mode = zerolog::LogMode::ASYNC;
+        options.queue_capacity = 256;
+        zerolog::Logger<CaptureSink> logger(CaptureSink{&text, std::chrono::microseconds(1)}, options);
+        log_from_threads(logger, threads, per_thread);
+    }
+    expect_sequences(text, threads, per_thread, what);
+    printf("%s: %d records\n", what, threads * per_thread);
+}
+
+// Runs `command` and returns its stdout.
+inline std::string run(const std::string& command) {
+    std::string output;
+    FILE* pipe = popen(command.c_str(), "r");
+    expect(pipe != nullptr, "popen", command);
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, n);
+    }
+    expect(pclose(pipe) == 0, "command failed", command);
+    return output;
+}
+
+} // namespace zerolog_test
@@ -0,0 +1,207 @@
+#include "zerolog/core_registry.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Prints the records a crashed process still held in its rings and
+// per-thread batches to stdout, in timestamp order, from its ELF core file.
+// The process needs no crash handler: zerolog_core_root (see
+// core_registry.hpp) is found by its magic and followed through the core's
+// memory segments. Not covered: elastic chunk queues, which are not
+// registered, so records still queued in them are lost; records the worker
+// already copied into the sink's buffers; and persistent rings, which
+// zerolog_recover reads from their file.
+
+namespace {
+
+using zerolog::detail::CoreRegion;
+using zerolog::detail::CoreRoot;
+
+struct Segment {
+    uint64_t vaddr, size;  // size: bytes present in the file
+    const char* data;
+};
+
+class Core {
+public:
+    explicit Core(const char* path) {
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || ::fstat(fd, &st) != 0) {
+            const int err = errno;
+            if (fd >= 0) ::close(fd);
+            throw std::runtime_error(strerror(err));
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* mapping = size_ ? ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            throw std::runtime_error("cannot map file");
+        }
+        data_ = static_cast<const char*>(mapping);
+
+        Elf64_Ehdr ehdr;
+        if (size_ < sizeof(ehdr) || memcmp(data_, ELFMAG, SELFMAG) != 0 ||
+            data_[EI_CLASS] != ELFCLASS64) {
+            throw std::runtime_error("not a 64-bit ELF file");
+        }
+        memcpy(&ehdr, data_, sizeof(ehdr));
+        if (ehdr.e_type != ET_CORE) {
+            throw std::runtime_error("not a core file");
+        }
+        for (size_t i = 0; i < ehdr.e_phnum; ++i) {
+            Elf64_Phdr phdr;
+            const uint64_t at = ehdr.e_phoff + i * sizeof(phdr);
+            if (at + sizeof(phdr) > size_) break;
+            memcpy(&phdr, data_ + at, sizeof(phdr));
+            if (phdr.p_type != PT_LOAD || phdr.p_offset > size_) continue;
+            // Segments the kernel did not dump have p_filesz 0.
+            const uint64_t present = std::min<uint64_t>(phdr.p_filesz, size_ - phdr.p_offset);
+            if (present) {
+                segments_.push_back({phdr.p_vaddr, present, data_ + phdr.p_offset});
+            }
+        }
+    }
+
+    ~Core() { ::munmap(const_cast<char*>(data_), size_); }
+
+    // Copies `len` bytes at process address `addr`; false if not in the core.
+    bool read(uint64_t addr, void* out, size_t len) const {
+        for (const Segment& seg : segments_) {
+            if (addr >= seg.vaddr && addr - seg.vaddr <= seg.size && len <= seg.size - (addr - seg.vaddr)) {
+                memcpy(out, seg.data + (addr - seg.vaddr), len);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename T>
+    bool read(uint64_t addr, T& out) const { return read(addr, &out, sizeof(out)); }
+
+    // Addresses of every valid root: the executable's and any other copy of
+    // libzerolog linked into a shared object.
+    std::vector<uint64_t> find_roots() const {
+        std::vector<uint64_t> roots;
+        const char* magic = zerolog::detail::CORE_MAGIC;
+        for (const Segment& seg : segments_) {
+            const char* end = seg.data + seg.size;
+            for (const char* p = seg.data; end - p >= static_cast<ptrdiff_t>(sizeof(CoreRoot));
+                 p += alignof(CoreRoot)) {
+                if (memcmp(p, magic, sizeof(CoreRoot::magic)) != 0) continue;
+                CoreRoot root;
+                memcpy(&root, p, sizeof(root));
+                if (root.version == zerolog::detail::CORE_VERSION &&
+                    root.trailer_size == sizeof(uint64_t) + sizeof(uint16_t)) {
+                    roots.push_back(seg.vaddr + static_cast<uint64_t>(p - seg.data));
+                }
+            }
+        }
+        return roots;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<Segment> segments_;
+};
+
+struct Record {
+    uint64_t timestamp;
+    std::string text;
+};
+
+// Reads the slots of one region; false if the region is not in the core.
+bool extract(const Core& core, const CoreRegion& region, std::vector<Record>& records) {
+    constexpr size_t TRAILER_SIZE = sizeof(uint64_t) + sizeof(uint16_t);
+    if (region.entry_size <= TRAILER_SIZE || region.entry_size > 65536 || region.capacity == 0 ||
+        region.capacity > (uint64_t{1} << 32)) {
+        return false;
+    }
+    uint64_t first = 0, last = 0;
+    if (region.kind == CoreRegion::RING) {
+        if (!core.read(region.head, first) || !core.read(region.tail, last)) return false;
+        last &= ~(uint64_t{1} << 63);  // sealed bit
+        if (last < first) return false;
+        first = std::max(first, last - std::min(last, region.capacity));
+    } else if (region.kind == CoreRegion::BATCH) {
+        if (!core.read(region.tail, last)) return false;
+        last = std::min(last, region.capacity);
+    } else {
+        return false;
+    }
+    std::vector<char> slot(region.entry_size);
+    for (uint64_t seq = first; seq < last; ++seq) {
+        if (!core.read(region.slots + (seq % region.capacity) * region.entry_size, slot.data(), slot.size())) {
+            return false;
+        }
+        uint16_t len;
+        uint64_t timestamp;
+        memcpy(&len, &slot[region.entry_size - sizeof(len)], sizeof(len));
+        memcpy(&timestamp, &slot[region.entry_size - TRAILER_SIZE], sizeof(timestamp));
+        // Zero length: reserved but never published. Deferred records start
+        // with '\0' and hold pointers into the dead process.
+        if (len == 0 || len > region.entry_size - TRAILER_SIZE || slot[0] == '\0') continue;
+        records.push_back({timestamp, std::string(slot.data(), len)});
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <core file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        Core core(argv[1]);
+        std::vector<uint64_t> roots = core.find_roots();
+        if (roots.empty()) {
+            fprintf(stderr, "%s: no zerolog_core_root in the core\n", argv[1]);
+            return 1;
+        }
+        std::vector<Record> records;
+        size_t regions = 0, missing = 0;
+        for (uint64_t root_addr : roots) {
+            CoreRoot root;
+            core.read(root_addr, root);
+            // Bounded, in case the list was corrupted along with the process.
+            uint64_t addr = root.regions;
+            for (size_t hops = 0; addr && hops < 100000; ++hops) {
+                CoreRegion region;
+                if (!core.read(addr, region)) {
+                    ++missing;
+                    break;
+                }
+                ++regions;
+                if (!extract(core, region, records)) ++missing;
+                addr = region.next;
+            }
+        }
+        // Records of one thread keep their relative order on equal timestamps.
+        std::stable_sort(records.begin(), records.end(),
+                         [](const Record& a, const Record& b) { return a.timestamp < b.timestamp; });
+        for (const Record& record : records) {
+            fwrite(record.text.data(), 1, record.text.size(), stdout);
+        }
+        fprintf(stderr, "%zu records from %zu regions", records.size(), regions);
+        if (missing) {
+            fprintf(stderr, " (%zu regions not in the core)", missing);
+        }
+        fprintf(stderr, "\n");
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s: %s\n", argv[1], e.what());
+        return 1;
+    }
+    return 0;
+}
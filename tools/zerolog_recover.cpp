@@ -0,0 +1,36 @@
+#include "zerolog/ring_file.hpp"
+#include <cstdio>
+#include <exception>
+
+// Prints the records a killed process left unwritten in its persistent ring
+// (LoggerOptions::persistent_path) to stdout, oldest first. The file is only
+// read; a logger opened on it later still writes them itself.
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <ring file>\n", argv[0]);
+        return 2;
+    }
+    try {
+        zerolog::RingFile file(argv[1], false);
+        if (file.in_use()) {
+            fprintf(stderr, "%s: warning: in use by a running logger, records may change while read\n", argv[1]);
+        }
+        if (!file.mapped()) {
+            fprintf(stderr, "%s: not a zerolog ring file\n", argv[1]);
+            return 1;
+        }
+        size_t recovered = 0;
+        file.for_each_pending([&](const char* record, size_t len, uint64_t) {
+            // Deferred records hold pointers into the dead process.
+            if (record[0] != '\0') {
+                fwrite(record, 1, len, stdout);
+                ++recovered;
+            }
+        });
+        fprintf(stderr, "%zu records recovered\n", recovered);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s: %s\n", argv[1], e.what());
+        return 1;
+    }
+    return 0;
+}